@@ -7,6 +7,7 @@
  * This license is available at: http://opensource.org/licenses/Apache-2.0.
  */
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,14 +15,45 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #include "psautohint.h"
 
+/* Each thread hinting files with -j has its own current file. */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/* A bez file hinted with -j. The output, report and messages are kept until
+ * all the files before it are done, so they are written in the same order as
+ * when hinting the files one by one. */
+typedef struct
+{
+    char* name;
+    char* output;
+    char* report;
+    size_t reportLength;
+    char* messages;
+    size_t messagesLength;
+    int result;
+    bool done;
+} BezFile;
+
 static const char* C_ProgramVersion = "1.65240";
 static const char* reportExt = ".rpt";
 static const char* dfltExt = ".new";
-static char* bezName = NULL;
+static THREAD_LOCAL char* bezName = NULL;
 static char* fileSuffix = NULL;
-static FILE* reportFile = NULL;
+static THREAD_LOCAL FILE* reportFile = NULL;
+static THREAD_LOCAL BezFile* currentFile = NULL;
 
 static bool verbose = true; /* if true don't number of characters processed. */
 static bool debug = false;
@@ -40,8 +72,8 @@ printUsage(void)
 {
     fprintf(stdout, "Usage: autohintexe [-u] [-h]\n");
     fprintf(stdout, "       autohintexe  -f <font info name> [-e] [-n] "
-                    "[-q] [-s <suffix>] [-ra] [-rs] -a] [<file1> <file2> "
-                    "... <filen>]\n");
+                    "[-q] [-s <suffix>] [-ra] [-rs] -a] [-j <n>] [<file1> "
+                    "<file2> ... <filen>]\n");
     printVersions();
 }
 
@@ -72,39 +104,88 @@ printHelp(void)
                     "change glyph. Default extension is '.rpt'\n");
     fprintf(stdout, "   -a Modifies -ra and -rs: Includes stems between "
                     "curved lines: default is to omit these.\n");
+    fprintf(stdout, "   -j <n> Hint the files using n threads. The output "
+                    "files and messages are\n");
+    fprintf(stdout, "       the same as when hinting them one by one.\n");
     fprintf(stdout, "   -v print versions.\n");
 }
 
+/* Appends the formatted text to the text of the given length. */
+static void
+appendText(char** text, size_t* length, const char* format, ...)
+{
+    va_list args;
+    int size;
+
+    va_start(args, format);
+    size = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (size < 0)
+        return;
+
+    *text = realloc(*text, *length + size + 1);
+    if (*text == NULL) {
+        fprintf(stdout, "Error. Could not allocate memory for messages.\n");
+        exit(AC_FatalError);
+    }
+
+    va_start(args, format);
+    vsnprintf(*text + *length, size + 1, format, args);
+    va_end(args);
+    *length += size;
+}
+
+/* Writes a line of the report, to the report file or, with -j, to the
+ * report of the file being hinted. */
+static void
+writeReport(const char* kind, const char* glyphName, const char* side1,
+            int value1, const char* side2, int value2)
+{
+    BezFile* file = currentFile;
+
+    if (file != NULL)
+        appendText(&file->report, &file->reportLength, "%s %s %s %f %s %f\n",
+                   kind, glyphName, side1, value1 / 256.0, side2,
+                   value2 / 256.0);
+    else if (reportFile)
+        fprintf(reportFile, "%s %s %s %f %s %f\n", kind, glyphName, side1,
+                value1 / 256.0, side2, value2 / 256.0);
+}
+
 static void
 charZoneCB(int top, int bottom, char* glyphName)
 {
-    if (reportFile)
-        fprintf(reportFile, "charZone %s top %f bottom %f\n", glyphName,
-                top / 256.0, bottom / 256.0);
+    writeReport("charZone", glyphName, "top", top, "bottom", bottom);
 }
 
 static void
 stemZoneCB(int top, int bottom, char* glyphName)
 {
-    if (reportFile)
-        fprintf(reportFile, "stemZone %s top %f bottom %f\n", glyphName,
-                top / 256.0, bottom / 256.0);
+    writeReport("stemZone", glyphName, "top", top, "bottom", bottom);
 }
 
 static void
 hstemCB(int top, int bottom, char* glyphName)
 {
-    if (reportFile)
-        fprintf(reportFile, "HStem %s top %f bottom %f\n", glyphName,
-                top / 256.0, bottom / 256.0);
+    writeReport("HStem", glyphName, "top", top, "bottom", bottom);
 }
 
 static void
 vstemCB(int right, int left, char* glyphName)
 {
-    if (reportFile)
-        fprintf(reportFile, "VStem %s right %f left %f\n", glyphName,
-                right / 256.0, left / 256.0);
+    writeReport("VStem", glyphName, "right", right, "left", left);
+}
+
+static void
+printMessage(const char* prefix, char* msg)
+{
+    BezFile* file = currentFile;
+
+    if (file == NULL)
+        fprintf(stdout, "%s: %s\n", prefix, msg);
+    else
+        appendText(&file->messages, &file->messagesLength, "%s: %s\n", prefix,
+                   msg);
 }
 
 static void
@@ -113,18 +194,18 @@ reportCB(char* msg, int level)
     switch (level) {
         case -1: /* LOGDEBUG */
             if (debug)
-                fprintf(stdout, "DEBUG: %s\n", msg);
+                printMessage("DEBUG", msg);
             break;
         case 0: /* INFO */
             if (verbose)
-                fprintf(stdout, "INFO: %s\n", msg);
+                printMessage("INFO", msg);
             break;
         case 1: /* WARNING */
             if (verbose)
-                fprintf(stdout, "WARNING: %s\n", msg);
+                printMessage("WARNING", msg);
             break;
         case 2: /* LOGERROR */
-            fprintf(stdout, "ERROR: %s\n", msg);
+            printMessage("ERROR", msg);
             break;
         default:
             break;
@@ -134,7 +215,11 @@ reportCB(char* msg, int level)
 static void
 reportRetry(void)
 {
-    if (reportFile != NULL) {
+    if (currentFile != NULL) {
+        currentFile->reportLength = 0;
+        if (currentFile->report != NULL)
+            currentFile->report[0] = '\0';
+    } else if (reportFile != NULL) {
         fclose(reportFile);
         openReportFile(bezName, fileSuffix);
     }
@@ -224,6 +309,221 @@ closeReportFile(void)
 {
     if (reportFile != NULL)
         fclose(reportFile);
+    reportFile = NULL;
+}
+
+/* The files hinted with -j, shared by the threads. */
+typedef struct
+{
+    BezFile* files;
+    int count;
+    int next;    /* next file to hint */
+    int written; /* next file to write */
+    int result;  /* result of the first file that failed */
+    const char* fontinfo;
+    bool allowEdit, allowHintSub, roundCoords, report;
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} HintJobs;
+
+static void
+lockJobs(HintJobs* jobs)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&jobs->lock);
+#else
+    pthread_mutex_lock(&jobs->lock);
+#endif
+}
+
+static void
+unlockJobs(HintJobs* jobs)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&jobs->lock);
+#else
+    pthread_mutex_unlock(&jobs->lock);
+#endif
+}
+
+/* Writes the files that are done, in order, up to the first one that is not.
+ * Like the serial loop in main(), stops at the first file that failed. Must be
+ * called with the jobs locked. */
+static void
+writeJobs(HintJobs* jobs)
+{
+    while (jobs->written < jobs->count && jobs->files[jobs->written].done) {
+        BezFile* file = &jobs->files[jobs->written++];
+
+        if (file->messages != NULL) {
+            fputs(file->messages, stdout);
+            free(file->messages);
+            file->messages = NULL;
+        }
+
+        if (jobs->report) {
+            writeFileData(file->name, file->report ? file->report : "",
+                          fileSuffix);
+            free(file->report);
+            file->report = NULL;
+        } else if (file->output != NULL) {
+            writeFileData(file->name, file->output, fileSuffix);
+            free(file->output);
+            file->output = NULL;
+        }
+
+        if (file->result != AC_Success) {
+            jobs->result = file->result;
+            jobs->next = jobs->written = jobs->count;
+        }
+    }
+}
+
+static void
+hintJobs(HintJobs* jobs)
+{
+    ACContext* context = AC_NewContext();
+
+    for (;;) {
+        BezFile* file;
+        char* bezdata;
+        char* output;
+        size_t outputsize;
+
+        lockJobs(jobs);
+        file = jobs->next < jobs->count ? &jobs->files[jobs->next++] : NULL;
+        unlockJobs(jobs);
+
+        if (file == NULL)
+            break;
+
+        currentFile = file;
+        bezName = file->name;
+        bezdata = getFileData(bezName);
+        outputsize = 4 * strlen(bezdata);
+        output = malloc(outputsize);
+
+        /* The report is collected in file, and written with the output. */
+        file->result =
+          AutoHintStringCtx(context, bezdata, jobs->fontinfo, &output,
+                            &outputsize, jobs->allowEdit, jobs->allowHintSub,
+                            jobs->roundCoords);
+
+        if (jobs->report) {
+            free(output);
+        } else if ((outputsize != 0) && (file->result == AC_Success)) {
+            file->output = output;
+        } else {
+            free(output);
+        }
+
+        free(bezdata);
+        currentFile = NULL;
+
+        lockJobs(jobs);
+        file->done = true;
+        writeJobs(jobs);
+        unlockJobs(jobs);
+    }
+
+    AC_FreeContext(context);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+hintThread(LPVOID arg)
+{
+    hintJobs((HintJobs*)arg);
+    return 0;
+}
+#else
+static void*
+hintThread(void* arg)
+{
+    hintJobs((HintJobs*)arg);
+    return NULL;
+}
+#endif
+
+/* Hints the bez files using nthreads threads, each with its own context. */
+static int
+hintFilesParallel(char** names, int count, const char* fontinfo,
+                  bool allowEdit, bool allowHintSub, bool roundCoords,
+                  bool report, int nthreads)
+{
+    HintJobs jobs;
+    int i, started = 0;
+#ifdef _WIN32
+    HANDLE* threads;
+#else
+    pthread_t* threads;
+#endif
+
+    memset(&jobs, 0, sizeof(jobs));
+    jobs.files = calloc(count, sizeof(BezFile));
+    threads = calloc(nthreads, sizeof(*threads));
+    if (jobs.files == NULL || threads == NULL) {
+        fprintf(stdout, "Error. Could not allocate memory for the files.\n");
+        exit(AC_FatalError);
+    }
+
+    for (i = 0; i < count; i++)
+        jobs.files[i].name = names[i];
+    jobs.count = count;
+    jobs.result = AC_Success;
+    jobs.fontinfo = fontinfo;
+    jobs.allowEdit = allowEdit;
+    jobs.allowHintSub = allowHintSub;
+    jobs.roundCoords = roundCoords;
+    jobs.report = report;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&jobs.lock);
+    for (i = 0; i < nthreads; i++) {
+        threads[started] = CreateThread(NULL, 0, hintThread, &jobs, 0, NULL);
+        if (threads[started] != NULL)
+            started++;
+    }
+#else
+    pthread_mutex_init(&jobs.lock, NULL);
+    for (i = 0; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, hintThread, &jobs) == 0)
+            started++;
+    }
+#endif
+
+    /* If no thread could be started, hint the files in this one. */
+    if (started == 0)
+        hintJobs(&jobs);
+
+    for (i = 0; i < started; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&jobs.lock);
+#else
+    pthread_mutex_destroy(&jobs.lock);
+#endif
+
+    /* Files hinted after one that failed are not written. */
+    for (i = 0; i < count; i++) {
+        free(jobs.files[i].output);
+        free(jobs.files[i].report);
+        free(jobs.files[i].messages);
+    }
+    free(jobs.files);
+    free(threads);
+
+    return jobs.result;
 }
 
 int
@@ -248,6 +548,7 @@ main(int argc, char* argv[])
 
     int16_t total_files = 0;
     int result, argi;
+    int nthreads = 1;
 
     badParam = false;
     allStems = false;
@@ -350,6 +651,15 @@ main(int argc, char* argv[])
             case 'a':
                 allStems = true;
                 break;
+            case 'j':
+                nthreads = atoi(argv[++argi]);
+                if (nthreads < 1) {
+                    fprintf(stdout, "Error. Illegal command line. \"-j\" "
+                                    "option must be followed by a number "
+                                    "greater than 0.\n");
+                    exit(1);
+                }
+                break;
 
             case 'r':
                 allowEdit = allowHintSub = false;
@@ -399,8 +709,19 @@ main(int argc, char* argv[])
         exit(AC_InvalidParameterError);
 
     AC_SetReportCB(reportCB);
+    /* Don't have the library format messages that won't be printed. */
+    AC_SetReportLevel(debug ? AC_LogDebug : verbose ? AC_LogInfo : AC_LogError);
     argi = firstFileNameIndex - 1;
-    if (!doMM)
+    if (!doMM && nthreads > 1 && !argumentIsBezData)
+    {
+        result = hintFilesParallel(&argv[firstFileNameIndex],
+                                   argc - firstFileNameIndex, fontinfo,
+                                   allowEdit, allowHintSub, roundCoords,
+                                   report, nthreads);
+        if (result != AC_Success)
+            exit(result);
+    }
+    else if (!doMM)
     {
         while (++argi < argc) {
             char* bezdata;
@@ -77,6 +77,28 @@ typedef void (*AC_REPORTFUNCPTR)(char* msg, int level);
 
 ACLIB_API void AC_SetReportCB(AC_REPORTFUNCPTR reportCB);
 
+/*
+ * Function: AC_SetReportLevel
+ *
+ * Messages of a level lower than the given one are not passed to the report
+ * callback, and are not even formatted. Errors still stop the hinting of the
+ * glyph when they are not reported. Like the callbacks, the level is copied
+ * into the contexts created afterwards; the default is AC_LogDebug, which
+ * reports everything.
+ *
+ * The debug messages are left out altogether when the library is built with
+ * AC_NO_DEBUG_LOGGING defined.
+ */
+enum
+{
+    AC_LogDebug = -1,
+    AC_LogInfo,
+    AC_LogWarning,
+    AC_LogError
+};
+
+ACLIB_API void AC_SetReportLevel(int level);
+
 /*
  * Function: AC_SetReportStemsCB
  *
@@ -132,8 +154,11 @@ ACLIB_API void AC_SetReportRetryCB(AC_RETRYPTR retryCB);
  *
  * Hint information is added to the bez data and returned to the caller through
  * the buffer dstbezdata. dstbezdata must be allocated before the call and a
- * pointer to its length passed as *length. If the space allocated is
- * insufficient for the target bezdata, it will be reallocated as needed.
+ * pointer to its length passed as *length. The bez data is written directly
+ * into it; if the space allocated is insufficient for the target bezdata, it
+ * will be reallocated as needed, so the initial size may be a rough guess.
+ * On success *length is set to the length of the data plus the terminating
+ * null. On failure the content of the buffer is undefined.
  */
 ACLIB_API int AutoHintString(const char* srcbezdata, const char* fontinfo,
                              char** dstbezdata, size_t* length, int allowEdit,
@@ -147,6 +172,330 @@ ACLIB_API int AutoHintStringMM(const char** srcbezdata, const char* fontinfo,
                                int nmasters, const char** masters,
                                char** dstbezdata, size_t* lengths);
 
+/*
+ * Type: ACContext
+ *
+ * An opaque handle owning the state of the hinting calls made through it:
+ * the reporting callbacks, the memory used while hinting a glyph, and the
+ * output buffer. A context may only be used by one thread at a time, but
+ * different threads may hint glyphs concurrently each with its own context.
+ */
+typedef struct _accontext ACContext;
+
+/*
+ * Function: AC_NewContext
+ *
+ * Creates a new hinting context. The callbacks set with AC_SetReportCB(),
+ * AC_SetReportStemsCB(), AC_SetReportZonesCB() and AC_SetReportRetryCB() at
+ * the time of the call are copied into it. Returns NULL if memory could not be
+ * allocated.
+ */
+ACLIB_API ACContext* AC_NewContext(void);
+
+/*
+ * Function: AC_SetContextMemSize
+ *
+ * Sets the size of the blocks of memory the context allocates for hinting a
+ * glyph. The context starts with one block and adds more when a glyph needs
+ * them; the blocks are kept for the following glyphs. Passing 0 restores the
+ * default size of 64 KB.
+ */
+ACLIB_API void AC_SetContextMemSize(ACContext* context, size_t size);
+
+/*
+ * Function: AC_SetContextReportLevel
+ *
+ * Sets the report level of the context, overriding the one copied from
+ * AC_SetReportLevel() when it was created. Threads hinting with their own
+ * contexts should use this rather than changing the process-wide default.
+ */
+ACLIB_API void AC_SetContextReportLevel(ACContext* context, int level);
+
+/*
+ * Function: AC_FreeContext
+ *
+ * Releases a context created by AC_NewContext() and all memory it owns.
+ */
+ACLIB_API void AC_FreeContext(ACContext* context);
+
+/*
+ * Function: AutoHintStringCtx
+ *
+ * Same as AutoHintString(), but uses the given context instead of a temporary
+ * one, so repeated calls reuse its memory.
+ */
+ACLIB_API int AutoHintStringCtx(ACContext* context, const char* srcbezdata,
+                                const char* fontinfo, char** dstbezdata,
+                                size_t* length, int allowEdit,
+                                int allowHintSub, int roundCoords);
+
+/*
+ * Function: AutoHintStringMMCtx
+ *
+ * Same as AutoHintStringMM(), but uses the given context.
+ */
+ACLIB_API int AutoHintStringMMCtx(ACContext* context, const char** srcbezdata,
+                                  const char* fontinfo, int nmasters,
+                                  const char** masters, char** dstbezdata,
+                                  size_t* lengths);
+
+/*
+ * Function: AutoHintStringBatch
+ *
+ * Hints nglyphs glyphs that share the same fontinfo, which is parsed only
+ * once. srcbezdata, dstbezdata and lengths are arrays of nglyphs entries;
+ * each glyph is hinted as by AutoHintString() into dstbezdata[i], whose
+ * allocated size is passed in lengths[i]. If results is not NULL, it receives
+ * the result of each glyph.
+ *
+ * A glyph that fails does not stop the others from being hinted. Returns
+ * AC_Success if all the glyphs were hinted, otherwise the result of the first
+ * one that failed.
+ */
+ACLIB_API int AutoHintStringBatch(const char* fontinfo,
+                                  const char** srcbezdata, int nglyphs,
+                                  char** dstbezdata, size_t* lengths,
+                                  int* results, int allowEdit,
+                                  int allowHintSub, int roundCoords);
+
+/*
+ * Function: AutoHintStringParallel
+ *
+ * Same as AutoHintStringBatch(), but hints the glyphs using up to nthreads
+ * threads, each with its own context. Threads that finish their glyphs early
+ * take over the remaining ones, so uneven glyph complexity does not leave them
+ * idle. The results are stored in the same order and are identical to those
+ * of AutoHintStringBatch(). If nthreads is 1 or less, the glyphs are hinted
+ * in the calling thread.
+ *
+ * The callbacks set with AC_SetReportCB() and the other AC_SetReport*
+ * functions may be called concurrently from the different threads.
+ */
+ACLIB_API int AutoHintStringParallel(const char* fontinfo,
+                                     const char** srcbezdata, int nglyphs,
+                                     char** dstbezdata, size_t* lengths,
+                                     int* results, int allowEdit,
+                                     int allowHintSub, int roundCoords,
+                                     int nthreads);
+
+/*
+ * Type: ACFontInfo
+ *
+ * An opaque handle holding a parsed fontinfo together with the values the
+ * hinting derives from it: the alignment zones, the standard stem widths,
+ * BlueFuzz, the flex settings and the counter hint glyph lists. It is not
+ * modified while hinting, so it can be shared by several contexts, including
+ * ones used by different threads.
+ */
+typedef struct _acfontinfo ACFontInfo;
+
+/*
+ * Function: AC_CompileFontInfo
+ *
+ * Parses fontinfo, a null terminated C string in the same format passed to
+ * AutoHintString(), and derives the hinting values from it. Errors are
+ * reported through the callback set with AC_SetReportCB(). Returns NULL if
+ * the fontinfo is invalid or memory could not be allocated.
+ */
+ACLIB_API ACFontInfo* AC_CompileFontInfo(const char* fontinfo);
+
+/*
+ * Function: AC_FreeFontInfo
+ *
+ * Releases a fontinfo returned by AC_CompileFontInfo().
+ */
+ACLIB_API void AC_FreeFontInfo(ACFontInfo* fontinfo);
+
+/*
+ * Function: AutoHintStringFontInfo
+ *
+ * Same as AutoHintStringCtx(), but takes a fontinfo compiled with
+ * AC_CompileFontInfo(), so glyphs using different font dictionaries can be
+ * hinted without parsing their fontinfo again.
+ */
+ACLIB_API int AutoHintStringFontInfo(ACContext* context,
+                                     const ACFontInfo* fontinfo,
+                                     const char* srcbezdata,
+                                     char** dstbezdata, size_t* length,
+                                     int allowEdit, int allowHintSub,
+                                     int roundCoords);
+
+/*
+ * Function: AutoHintStringWrite
+ *
+ * Same as AutoHintStringFontInfo(), but instead of returning the hinted bez
+ * data in a buffer, passes it to writeCB in pieces as it is produced, together
+ * with userData. The pieces are not null terminated.
+ *
+ * If the call fails, part of the glyph may already have been passed to
+ * writeCB, and should be discarded.
+ */
+typedef void (*AC_WRITEFUNCPTR)(void* userData, const char* data,
+                                size_t length);
+
+ACLIB_API int AutoHintStringWrite(ACContext* context,
+                                  const ACFontInfo* fontinfo,
+                                  const char* srcbezdata,
+                                  AC_WRITEFUNCPTR writeCB, void* userData,
+                                  int allowEdit, int allowHintSub,
+                                  int roundCoords);
+
+/*
+ * Type: ACPath
+ *
+ * A glyph outline given as arrays instead of bez text. ops holds nops path
+ * operators, and coords their absolute coordinates in order: x y for
+ * AC_MOVETO and AC_LINETO, x1 y1 x2 y2 x3 y3 for AC_CURVETO, and none for
+ * AC_CLOSEPATH. Coordinates are 24.8 fixed point numbers, i.e. multiplied by
+ * AC_FIXEDONE, with y pointing up.
+ */
+enum
+{
+    AC_MOVETO = 0,
+    AC_LINETO = 1,
+    AC_CURVETO = 2,
+    AC_CLOSEPATH = 3
+};
+
+#define AC_FIXEDONE 256
+
+typedef struct
+{
+    const char* name; /* glyph name, used in messages */
+    int nops;
+    const unsigned char* ops;
+    const int* coords;
+} ACPath;
+
+/*
+ * Type: ACHintResult
+ *
+ * The hinted glyph returned by AutoHintPath(). ops and coords hold the path
+ * as in ACPath; it differs from the input when allowEdit is set, and its
+ * coordinates are rounded when roundCoords is set. flex[i] is 1 when the
+ * curve ops[i] is one of the two halves of a flex.
+ *
+ * The stems are grouped in hint sets: hintsets[k] lists the count stems
+ * starting at stems[first], which are in effect from the path operator with
+ * index op until the next set. The first set holds the initial hints and
+ * normally starts at op 0; the others are hint replacements. A set never
+ * repeats the one before it, and a glyph without hints has no sets.
+ */
+typedef struct
+{
+    char type;     /* 'b' horizontal and 'y' vertical stem, 'v' and 'm' the
+                      same for the stems of hstem3 and vstem3 */
+    int pos;       /* bottom or left edge, 24.8 fixed */
+    int width;     /* 24.8 fixed */
+    int elt0, elt1; /* indexes of the path operators the edges were
+                       derived from, or -1 */
+} ACStem;
+
+typedef struct
+{
+    int op;
+    int first;
+    int count;
+} ACHintSet;
+
+typedef struct
+{
+    int nops;
+    unsigned char* ops;
+    int* coords;
+    unsigned char* flex;
+    int nstems;
+    ACStem* stems;
+    int nhintsets;
+    ACHintSet* hintsets;
+} ACHintResult;
+
+/*
+ * Function: AutoHintPath
+ *
+ * Same as AutoHintStringFontInfo(), but takes the glyph as an ACPath and
+ * returns the result in *result as arrays, so that the caller does not need to
+ * write and parse bez text. The result is allocated with the memory manager
+ * and must be released with AC_FreeHintResult(). *result is NULL on failure.
+ */
+ACLIB_API int AutoHintPath(ACContext* context, const ACFontInfo* fontinfo,
+                           const ACPath* path, ACHintResult** result,
+                           int allowEdit, int allowHintSub, int roundCoords);
+
+/*
+ * Function: AC_FreeHintResult
+ *
+ * Releases a result returned by AutoHintPath().
+ */
+ACLIB_API void AC_FreeHintResult(ACHintResult* result);
+
+/*
+ * Type: ACSubrs
+ *
+ * The local or global subroutines of a CFF font, as in its Subrs and
+ * GlobalSubrs INDEXes: data[i] is subroutine i, lengths[i] its size in bytes.
+ */
+typedef struct
+{
+    int count;
+    const unsigned char* const* data;
+    const size_t* lengths;
+} ACSubrs;
+
+/*
+ * Function: AC_DecodeCharstring
+ *
+ * Decodes a Type 2 charstring into an ACPath for AutoHintPath(), so that CFF
+ * glyphs can be hinted without converting them to bez first. The subroutine
+ * numbers are biased as in the Type 2 specification; either localSubrs or
+ * globalSubrs may be NULL when the font has none.
+ *
+ * The path is the one the bez conversion of the glyph would give: flex is
+ * turned into curves and the hints are dropped. Coordinates are rounded to
+ * integers, or to two decimals when allowDecimals is set. *width is the
+ * width operand of the charstring, relative to nominalWidthX and not rounded,
+ * and *hasWidth tells whether the charstring has one.
+ *
+ * Returns AC_FatalError for an invalid charstring and for the operators that
+ * are not supported: endchar with seac arguments, the arithmetic operators
+ * and blend.
+ * The path is allocated with the memory manager and must be released with
+ * AC_FreePath().
+ */
+ACLIB_API int AC_DecodeCharstring(const char* name,
+                                  const unsigned char* charstring,
+                                  size_t length, const ACSubrs* localSubrs,
+                                  const ACSubrs* globalSubrs,
+                                  int allowDecimals, ACPath** path,
+                                  double* width, int* hasWidth);
+
+/*
+ * Function: AC_FreePath
+ *
+ * Releases a path returned by AC_DecodeCharstring().
+ */
+ACLIB_API void AC_FreePath(ACPath* path);
+
+/*
+ * Function: AutoHintCharstring
+ *
+ * Same as AutoHintStringFontInfo(), but writes the hinted glyph as a Type 2
+ * charstring, with the hints in hstem(hm)/vstem(hm) operators, hintmask for
+ * hint substitution, cntrmask for the hstem3/vstem3 stems, and flex. This is
+ * the charstring otfFont.convertBezToT2() builds from the hinted bez, so the
+ * coordinates keep their two decimals when roundCoords is not set. width, if
+ * not NULL, is the width operand written first.
+ *
+ * *charstring and *length are used as in AutoHintString(), except that the
+ * charstring is not null terminated, and *length is set to its exact size.
+ */
+ACLIB_API int AutoHintCharstring(ACContext* context,
+                                 const ACFontInfo* fontinfo,
+                                 const char* srcbezdata, const double* width,
+                                 unsigned char** charstring, size_t* length,
+                                 int allowEdit, int allowHintSub,
+                                 int roundCoords);
+
 /*
  * Function: AC_initCallGlobals
  *
@@ -12,52 +12,100 @@
 
 #define MAXSTEMDIST 150 /* initial maximum stem width allowed for hints */
 
-PathElt *gPathStart, *gPathEnd;
-bool gUseV, gUseH, gAutoLinearCurveFix, gEditGlyph;
-bool gHasFlex, gFlexOK, gFlexStrict, gBandError;
-Fixed gHBigDist, gVBigDist, gInitBigDist, gMinDist, gGhostWidth, gGhostLength,
-  gBendLength, gBandMargin, gMaxFlare, gMaxBendMerge, gMaxMerge,
-  gMinHintElementLength, gFlexCand;
-Fixed gPruneA, gPruneB, gPruneC, gPruneD, gPruneValue, gBonus;
-float gTheta, gHBigDistR, gVBigDistR, gMaxVal, gMinVal;
-int32_t gLenTopBands, gLenBotBands, gNumSerifs, gDMin, gDelta, gCPpercent;
-int32_t gBendTan, gSCurveTan;
-HintVal *gVHinting, *gHHinting, *gVPrimary, *gHPrimary, *gValList;
-HintSeg* gSegLists[4];
-Fixed gVStems[MAXSTEMS], gHStems[MAXSTEMS];
-int32_t gNumVStems, gNumHStems;
-Fixed gTopBands[MAXBLUES], gBotBands[MAXBLUES], gSerifs[MAXSERIFS];
-HintPoint *gPointList, **gPtLstArray;
-int32_t gPtLstIndex, gNumPtLsts, gMaxPtLsts;
+AC_THREAD_LOCAL PathElt *gPathStart, *gPathEnd;
+AC_THREAD_LOCAL bool gUseV, gUseH, gAutoLinearCurveFix, gEditGlyph;
+AC_THREAD_LOCAL bool gHasFlex, gFlexOK, gFlexStrict, gBandError;
+AC_THREAD_LOCAL Fixed gHBigDist, gVBigDist, gInitBigDist, gMinDist,
+  gGhostWidth, gGhostLength, gBendLength, gBandMargin, gMaxFlare,
+  gMaxBendMerge, gMaxMerge, gMinHintElementLength, gFlexCand;
+AC_THREAD_LOCAL Fixed gPruneA, gPruneB, gPruneC, gPruneD, gPruneValue, gBonus;
+AC_THREAD_LOCAL float gTheta, gHBigDistR, gVBigDistR, gMaxVal, gMinVal;
+AC_THREAD_LOCAL int32_t gLenTopBands, gLenBotBands, gNumSerifs, gDMin, gDelta,
+  gCPpercent;
+AC_THREAD_LOCAL int32_t gBendTan, gSCurveTan;
+AC_THREAD_LOCAL HintVal *gVHinting, *gHHinting, *gVPrimary, *gHPrimary,
+  *gValList;
+AC_THREAD_LOCAL HintSeg* gSegLists[4];
+AC_THREAD_LOCAL Fixed gVStems[MAXSTEMS], gHStems[MAXSTEMS];
+AC_THREAD_LOCAL int32_t gNumVStems, gNumHStems;
+AC_THREAD_LOCAL Fixed gTopBands[MAXBLUES], gBotBands[MAXBLUES],
+  gSerifs[MAXSERIFS];
+AC_THREAD_LOCAL HintPoint *gPointList, **gPtLstArray;
+AC_THREAD_LOCAL int32_t gPtLstIndex, gNumPtLsts, gMaxPtLsts;
 bool gWriteHintedBez = true;
-Fixed gBlueFuzz;
-bool gDoAligns = false, gDoStems = false;
-bool gRoundToInt;
+AC_THREAD_LOCAL Fixed gBlueFuzz;
+AC_THREAD_LOCAL bool gRoundToInt;
 static int maxStemDist = MAXSTEMDIST;
 
-/* if false, then stems defined by curves are excluded from the reporting */
-unsigned int gAllStems = false;
-AC_REPORTSTEMPTR gAddHStemCB = NULL;
-AC_REPORTSTEMPTR gAddVStemCB = NULL;
-AC_REPORTZONEPTR gAddGlyphExtremesCB = NULL;
-AC_REPORTZONEPTR gAddStemExtremesCB = NULL;
-AC_RETRYPTR gReportRetryCB = NULL;
+#define VMCHUNKDATA(c) ((unsigned char*)((c) + 1))
 
-#define VMSIZE (1000000)
-static unsigned char *vmfree, *vmlast, vm[VMSIZE];
+/* Moves on to the chunk after the current one, first adding a chunk of at
+ * least sz bytes there unless the next chunk is already large enough. */
+static VMChunk*
+NextChunk(size_t sz)
+{
+    VMChunk* current = gContext->vmCurrent;
+    VMChunk* chunk = current != NULL ? current->next : gContext->vm;
+
+    if (chunk == NULL || chunk->size < sz) {
+        size_t size = NUMMAX(gContext->vmChunkSize, sz);
+
+        chunk = (VMChunk*)AllocateMem(1, sizeof(VMChunk) + size, "hints vm");
+        chunk->size = size;
+        chunk->used = 0;
+        if (current != NULL) {
+            chunk->next = current->next;
+            current->next = chunk;
+        } else {
+            chunk->next = gContext->vm;
+            gContext->vm = chunk;
+        }
+    }
+
+    gContext->vmCurrent = chunk;
+    return chunk;
+}
+
+/* Makes all of the current context's vm available again. Alloc() returns
+ * zeroed memory, so the part of each chunk that was handed out is cleared;
+ * the rest of it is still clear from the previous reset. */
+static void
+ResetVM(void)
+{
+    VMChunk* chunk;
+
+    for (chunk = gContext->vm; chunk != NULL; chunk = chunk->next) {
+        memset((void*)VMCHUNKDATA(chunk), 0x0, chunk->used);
+        chunk->used = 0;
+    }
+
+    gContext->vmCurrent = NULL;
+}
+
+void
+FreeVM(ACContext* context)
+{
+    VMChunk* chunk = context->vm;
+
+    while (chunk != NULL) {
+        VMChunk* next = chunk->next;
+        UnallocateMem(chunk);
+        chunk = next;
+    }
+    context->vm = context->vmCurrent = NULL;
+}
 
 /* sub allocator */
 unsigned char*
 Alloc(int32_t sz)
 {
     unsigned char* s;
-    sz = (sz + 3) & ~3; /* make size a multiple of 4 */
-    s = vmfree;
-    vmfree += sz;
-    if (vmfree > vmlast) /* Error! need to make VMSIZE bigger */
-    {
-        LogMsg(LOGERROR, FATALERROR, "Exceeded VM size for hints.");
-    }
+    VMChunk* chunk = gContext->vmCurrent;
+    sz = (sz + 7) & ~7; /* keep doubles and pointers aligned */
+    if (chunk == NULL || chunk->size - chunk->used < (size_t)sz)
+        chunk = NextChunk(sz);
+    s = VMCHUNKDATA(chunk) + chunk->used;
+    chunk->used += sz;
     return s;
 }
 
@@ -108,9 +156,7 @@ InitData(const ACFontInfo* fontinfo, int32_t reason)
             gBlueFuzz = DEFAULTBLUEFUZZ;
         /* fall through */
         case RESTART:
-            memset((void*)vm, 0x0, VMSIZE);
-            vmfree = vm;
-            vmlast = vm + VMSIZE;
+            ResetVM();
 
             /* ?? Does this cause a leak ?? */
             gPointList = NULL;
@@ -128,7 +174,7 @@ InitData(const ACFontInfo* fontinfo, int32_t reason)
 
 /* Returns whether hinting was successful. */
 bool
-AutoHint(const ACFontInfo* fontinfo, const char* srcbezdata,
+AutoHint(const ACFontInfo* fontinfo, const ACGlyphSource* glyph,
          bool extrahint, bool changeGlyph, bool roundCoords)
 {
     InitAll(fontinfo, STARTUP);
@@ -140,7 +186,7 @@ AutoHint(const ACFontInfo* fontinfo, const char* srcbezdata,
     gRoundToInt = roundCoords;
     gAutoLinearCurveFix = gEditGlyph;
 
-    return AutoHintGlyph(fontinfo, srcbezdata, extrahint);
+    return AutoHintGlyph(fontinfo, glyph, extrahint);
 }
 
 #if defined(_MSC_VER) && _MSC_VER < 1800
@@ -17,6 +17,7 @@
 
 #include "psautohint.h"
 
+#include "buffer.h"
 #include "logging.h"
 #include "memory.h"
 
@@ -159,53 +160,86 @@ typedef struct _hintpnt {
   bool done;
   } HintPoint;
 
+/* A block of memory the Alloc() sub-allocator hands out pieces of. A context
+ * keeps its chunks from one glyph to the next, and adds new ones when a glyph
+ * needs more memory. */
+typedef struct _vmchunk {
+  struct _vmchunk* next;
+  size_t size;          /* bytes of storage following this header */
+  size_t used;          /* bytes handed out since the chunk was last cleared,
+                           i.e. its high-water mark */
+} VMChunk;
+
+/* Default size of new chunks, see AC_SetContextMemSize(). */
+#define VMCHUNKSIZE (64 * 1024)
+
+/* The state owned by an ACContext handle, see psautohint.h. The callbacks are
+ * copied from the process-wide defaults set with AC_SetReportCB() and friends
+ * when the context is created. */
+struct _accontext {
+  AC_REPORTFUNCPTR reportCB;
+  int reportLevel;       /* lowest level passed to reportCB */
+  AC_REPORTSTEMPTR addHStemCB, addVStemCB;
+  AC_REPORTZONEPTR addGlyphExtremesCB, addStemExtremesCB;
+  AC_RETRYPTR reportRetryCB;
+  unsigned int allStems; /* if false, then stems defined by curves are
+                            excluded from the reporting */
+  bool doAligns, doStems;
+  VMChunk* vm;           /* storage for Alloc() */
+  VMChunk* vmCurrent;    /* the chunk Alloc() is handing out memory from */
+  size_t vmChunkSize;    /* size of the chunks added to vm */
+  PathElt* savedPath;    /* the glyph path set up for hinting, see SavePath()
+                            in control.c */
+  int32_t savedPathLen, savedPathSize;
+  jmp_buf mark;          /* where LogMsg() unwinds to on errors */
+  ACBuffer output;       /* where the glyph being hinted is written */
+};
+
+/* The glyph to hint, given either as bez text or as a path, see
+ * AutoHintPath(). */
 typedef struct {
-  char** keys;      /* font information keys */
-  char** values;    /* font information values */
-  size_t length;    /* number of the entries */
-} ACFontInfo;
-
-typedef struct {
-  char* data;       /* glyph data held in the buffer */
-  size_t length;    /* actual length of the data */
-  size_t capacity;  /* allocated memory size */
-} ACBuffer;
+  const char* bez;
+  const ACPath* path;
+} ACGlyphSource;
 
 /* global data */
 
-extern ACBuffer* gBezOutput;
+/* The context of the glyph being hinted on the current thread. It is set on
+ * entry to the AutoHintString*() functions. */
+extern AC_THREAD_LOCAL ACContext* gContext;
 
-extern PathElt* gPathStart, *gPathEnd;
-extern bool gUseV, gUseH, gAutoLinearCurveFix;
-extern bool gEditGlyph; /* whether glyph can be modified when adding hints */
-extern bool gBandError;
-extern bool gHasFlex, gFlexOK, gFlexStrict;
-extern Fixed gHBigDist, gVBigDist, gInitBigDist, gMinDist, gGhostWidth,
-  gGhostLength, gBendLength, gBandMargin, gMaxFlare,
+extern AC_THREAD_LOCAL ACBuffer* gBezOutput;
+/* When set, the hinted glyph is stored here instead of in gBezOutput. */
+extern AC_THREAD_LOCAL ACHintResult* gHintResult;
+/* When set, the hinted glyph is written to gBezOutput as a Type 2 charstring
+ * instead of bez, see AutoHintCharstring(). */
+typedef struct {
+  bool hasWidth;
+  double width;
+} ACCharstringOutput;
+extern AC_THREAD_LOCAL const ACCharstringOutput* gCharstringOutput;
+
+extern AC_THREAD_LOCAL PathElt* gPathStart, *gPathEnd;
+extern AC_THREAD_LOCAL bool gUseV, gUseH, gAutoLinearCurveFix;
+/* whether glyph can be modified when adding hints */
+extern AC_THREAD_LOCAL bool gEditGlyph;
+extern AC_THREAD_LOCAL bool gBandError;
+extern AC_THREAD_LOCAL bool gHasFlex, gFlexOK, gFlexStrict;
+extern AC_THREAD_LOCAL Fixed gHBigDist, gVBigDist, gInitBigDist, gMinDist,
+  gGhostWidth, gGhostLength, gBendLength, gBandMargin, gMaxFlare,
   gMaxBendMerge, gMaxMerge, gMinHintElementLength, gFlexCand;
-extern Fixed gPruneA, gPruneB, gPruneC, gPruneD, gPruneValue, gBonus;
-extern float gTheta, gHBigDistR, gVBigDistR, gMaxVal, gMinVal;
-extern int32_t gDMin, gDelta, gCPpercent, gBendTan, gSCurveTan;
-extern HintVal *gVHinting, *gHHinting, *gVPrimary, *gHPrimary, *gValList;
-extern HintSeg* gSegLists[4]; /* left, right, top, bot */
-extern HintPoint* gPointList, **gPtLstArray;
-extern int32_t gPtLstIndex, gNumPtLsts, gMaxPtLsts;
-
-/* global callbacks */
-
-/* if false, then stems defined by curves are excluded from the reporting */
-extern unsigned int gAllStems;
-
-extern AC_REPORTSTEMPTR gAddHStemCB;
-extern AC_REPORTSTEMPTR gAddVStemCB;
-
-extern AC_REPORTZONEPTR gAddGlyphExtremesCB;
-extern AC_REPORTZONEPTR gAddStemExtremesCB;
+extern AC_THREAD_LOCAL Fixed gPruneA, gPruneB, gPruneC, gPruneD, gPruneValue,
+  gBonus;
+extern AC_THREAD_LOCAL float gTheta, gHBigDistR, gVBigDistR, gMaxVal, gMinVal;
+extern AC_THREAD_LOCAL int32_t gDMin, gDelta, gCPpercent, gBendTan, gSCurveTan;
+extern AC_THREAD_LOCAL HintVal *gVHinting, *gHHinting, *gVPrimary, *gHPrimary,
+  *gValList;
+extern AC_THREAD_LOCAL HintSeg* gSegLists[4]; /* left, right, top, bot */
+extern AC_THREAD_LOCAL HintPoint* gPointList, **gPtLstArray;
+extern AC_THREAD_LOCAL int32_t gPtLstIndex, gNumPtLsts, gMaxPtLsts;
 
 void AddStemExtremes(Fixed bot, Fixed top);
 
-extern AC_RETRYPTR gReportRetryCB;
-
 #define leftList (gSegLists[0])
 #define rightList (gSegLists[1])
 #define topList (gSegLists[2])
@@ -214,22 +248,41 @@ extern AC_RETRYPTR gReportRetryCB;
 #define MAXFLEX (PSDist(20))
 #define MAXBLUES (20)
 #define MAXSERIFS (5)
-extern Fixed gTopBands[MAXBLUES], gBotBands[MAXBLUES], gSerifs[MAXSERIFS];
-extern int32_t gLenTopBands, gLenBotBands, gNumSerifs;
+extern AC_THREAD_LOCAL Fixed gTopBands[MAXBLUES], gBotBands[MAXBLUES],
+  gSerifs[MAXSERIFS];
+extern AC_THREAD_LOCAL int32_t gLenTopBands, gLenBotBands, gNumSerifs;
 #define MAXSTEMS (20)
-extern Fixed gVStems[MAXSTEMS], gHStems[MAXSTEMS];
-extern int32_t gNumVStems, gNumHStems;
-extern char *gHHintList[], *gVHintList[];
-extern int32_t gNumHHints, gNumVHints;
+extern AC_THREAD_LOCAL Fixed gVStems[MAXSTEMS], gHStems[MAXSTEMS];
+extern AC_THREAD_LOCAL int32_t gNumVStems, gNumHStems;
+#define COUNTERLISTSIZE (20)
+extern AC_THREAD_LOCAL char **gHHintList, **gVHintList;
+extern AC_THREAD_LOCAL int32_t gNumHHints, gNumVHints;
 extern bool gWriteHintedBez;
-extern Fixed gBlueFuzz;
-extern bool gDoAligns, gDoStems;
-extern bool gRoundToInt;
-extern bool gAddHints;
+extern AC_THREAD_LOCAL Fixed gBlueFuzz;
+extern AC_THREAD_LOCAL bool gRoundToInt;
+extern AC_THREAD_LOCAL bool gAddHints;
 
 #define MAX_GLYPHNAME_LEN 64
 /* defined in read.c; set from the glyph name at the start of the bex file. */
-extern char gGlyphName[MAX_GLYPHNAME_LEN];
+extern AC_THREAD_LOCAL char gGlyphName[MAX_GLYPHNAME_LEN];
+
+struct _acfontinfo {
+  char** keys;      /* font information keys */
+  char** values;    /* font information values */
+  size_t length;    /* number of the entries */
+
+  /* Values derived from the entries by CompileFontInfo(), and copied to the
+   * globals of the same names by ReadFontInfo() for each glyph. */
+  Fixed topBands[MAXBLUES], botBands[MAXBLUES];
+  int32_t lenTopBands, lenBotBands;
+  Fixed hStems[MAXSTEMS], vStems[MAXSTEMS];
+  int32_t numHStems, numVStems;
+  int32_t numHHints, numVHints;
+  Fixed blueFuzz;
+  bool flexOK, flexStrict;
+  char* hHintList[COUNTERLISTSIZE]; /* counter hinted glyphs */
+  char* vHintList[COUNTERLISTSIZE];
+};
 
 /* macros */
 
@@ -273,8 +326,11 @@ void acfixtopflt(Fixed x, float* pf);
 Fixed acpflttofix(float* pf);
 
 unsigned char* Alloc(int32_t sz); /* Sub-allocator */
+void FreeVM(ACContext* context);
 
-int AddCounterHintGlyphs(char* charlist, char* HintList[]);
+void InitCounterHintLists(char* HHintList[], char* VHintList[]);
+int AddCounterHintGlyphs(const char* charlist, char* HintList[]);
+void FreeCounterHintGlyphs(char* HintList[]);
 bool FindNameInList(char* nm, char** lst);
 void PruneElementHintSegs(void);
 int TestHintLst(SegLnkLst* lst, HintVal* hintList, bool flg, bool doLst);
@@ -296,8 +352,8 @@ void AddHintPoint(Fixed x0, Fixed y0, Fixed x1, Fixed y1, char ch, PathElt* p0,
 void AddHPair(HintVal* v, char ch);
 void AddVPair(HintVal* v, char ch);
 void XtraHints(PathElt* e);
-bool AutoHintGlyph(const ACFontInfo* fontinfo, const char* srcglyph,
-                    bool extrahint);
+bool AutoHintGlyph(const ACFontInfo* fontinfo, const ACGlyphSource* glyph,
+                   bool extrahint);
 void EvalV(void);
 void EvalH(void);
 void GenVPts(int32_t specialGlyphType);
@@ -390,10 +446,22 @@ void AddHSegment(Fixed from, Fixed to, Fixed loc, PathElt* p1, PathElt* p2,
 void Delete(PathElt* e);
 bool ReadGlyph(const ACFontInfo* fontinfo, const char* srcglyph,
                bool forBlendData, bool readHints);
+bool ReadGlyphPath(const ACPath* path);
 double FixToDbl(Fixed f);
 bool CompareValues(HintVal* val1, HintVal* val2, int32_t factor,
                    int32_t ghstshift);
 void SaveFile(const ACFontInfo* fontinfo);
+void FreeHintResult(ACHintResult* result);
+int DecodeCharstring(const char* name, const unsigned char* charstring,
+                     size_t length, const ACSubrs* localSubrs,
+                     const ACSubrs* globalSubrs, bool allowDecimals,
+                     ACPath** path, double* width, bool* hasWidth);
+void FreePath(ACPath* path);
+void SaveCharstring(void);
+/* Iterate over a hint point list in the order it is written in. */
+void ResetPntLst(HintPoint* lst);
+HintPoint* NextPntLst(HintPoint* lst);
+int CountPntLst(HintPoint* lst);
 void CheckForMultiMoveTo(void);
 #define STARTUP (0)
 #define RESTART (1)
@@ -407,11 +475,12 @@ void AddHStem(Fixed right, Fixed left, bool curved);
 
 void AddGlyphExtremes(Fixed bot, Fixed top);
 
-bool AutoHint(const ACFontInfo* fontinfo, const char* srcbezdata,
+bool AutoHint(const ACFontInfo* fontinfo, const ACGlyphSource* glyph,
               bool extrahint, bool changeGlyph, bool roundCoords);
 
 bool MergeGlyphPaths(const ACFontInfo* fontinfo, const char** srcglyphs,
                     int nmasters, const char** masters, char** outbuffers,
                     size_t* outlengths);
+void CleanupGlyphPaths(void);
 
 #endif /* AC_AC_H_ */
@@ -10,7 +10,7 @@
 #include "ac.h"
 #include "bbox.h"
 
-static bool mergeMain;
+static AC_THREAD_LOCAL bool mergeMain;
 
 static PathElt*
 GetSubPathNxt(PathElt* e)
@@ -418,6 +418,8 @@ TryResolveConflict(PathElt* e, bool Hflg)
     loc1 = Hflg ? y0 : x0;
     loc2 = Hflg ? y1 : x1;
     lst = Hflg ? e->Hs : e->Vs;
+    if (lst->next == NULL) /* only duplicates were in conflict */
+        return true;
     seg1 = lst->lnk->seg;
     lc1 = seg1->sLoc;
     lnk1 = lst;
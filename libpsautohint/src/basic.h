@@ -39,6 +39,17 @@ float roundf(float x);
 #endif /* _MSC_VER < 1800 */
 #endif /* _MSC_VER */
 
+/* Storage class for the hinting scratch state. Each thread hinting a glyph
+ * gets its own copy, so different threads can hint concurrently as long as
+ * each one uses its own ACContext. */
+#if defined(_MSC_VER)
+#define AC_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define AC_THREAD_LOCAL _Thread_local
+#else
+#define AC_THREAD_LOCAL __thread
+#endif
+
 typedef int32_t               Fixed;
 typedef int indx;		/* for indexes that could be either short or
 				   long - let the compiler decide */
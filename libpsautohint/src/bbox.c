@@ -10,8 +10,8 @@
 #include "bbox.h"
 #include "ac.h"
 
-static Fixed xmin, ymin, xmax, ymax, vMn, vMx, hMn, hMx;
-static PathElt *pxmn, *pxmx, *pymn, *pymx, *pe, *pvMn, *pvMx, *phMn, *phMx;
+static AC_THREAD_LOCAL Fixed xmin, ymin, xmax, ymax, vMn, vMx, hMn, hMx;
+static AC_THREAD_LOCAL PathElt *pxmn, *pxmx, *pymn, *pymx, *pe, *pvMn, *pvMx, *phMn, *phMx;
 
 static void
 FPBBoxPt(Cd c)
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+#include <math.h>
+
+#include "ac.h"
+#include "buffer.h"
+
+ACBuffer*
+NewBuffer(size_t size)
+{
+    ACBuffer* buffer;
+
+    if (size == 0)
+        return NULL;
+
+    buffer = (ACBuffer*)AllocateMem(1, sizeof(ACBuffer), "out buffer");
+    if (!buffer)
+        return NULL;
+
+    buffer->data = AllocateMem(size, 1, "out buffer data");
+    if (!buffer->data) {
+        UnallocateMem(buffer);
+        return NULL;
+    }
+
+    buffer->data[0] = '\0';
+    buffer->capacity = size;
+    buffer->length = 0;
+    buffer->writeCB = NULL;
+    buffer->userData = NULL;
+
+    return buffer;
+}
+
+void
+FreeBuffer(ACBuffer* buffer)
+{
+    if (!buffer)
+        return;
+
+    UnallocateMem(buffer->data);
+    UnallocateMem(buffer);
+}
+
+void
+BufferWrite(ACBuffer* buffer, const char* str, size_t len)
+{
+    if (!buffer) {
+        LogMsg(LOGERROR, FATALERROR, "NULL output buffer while writing glyph.");
+        return;
+    }
+
+    if (buffer->writeCB) {
+        if ((buffer->length + len) > buffer->capacity) {
+            FlushBuffer(buffer);
+            if (len > buffer->capacity) {
+                buffer->writeCB(buffer->userData, str, len);
+                return;
+            }
+        }
+        memcpy(buffer->data + buffer->length, str, len);
+        buffer->length += len;
+        return;
+    }
+
+    if ((buffer->length + len) >= buffer->capacity) {
+        size_t desiredsize =
+          NUMMAX(buffer->capacity * 2, buffer->length + len + 1);
+        char* data = ReallocateMem(buffer->data, desiredsize, "output bez data");
+        if (!data) {
+            LogMsg(LOGERROR, FATALERROR, "Cannot grow the output buffer.");
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = desiredsize;
+    }
+    memcpy(buffer->data + buffer->length, str, len);
+    buffer->length += len;
+    buffer->data[buffer->length] = '\0';
+}
+
+void
+BufferWriteString(ACBuffer* buffer, const char* str)
+{
+    BufferWrite(buffer, str, strlen(str));
+}
+
+void
+BufferWriteInt(ACBuffer* buffer, int32_t i)
+{
+    char buf[MAXBUFFLEN + 1];
+    BufferWrite(buffer, buf, FormatInt(buf, i));
+}
+
+void
+BufferWriteFloat2(ACBuffer* buffer, float f)
+{
+    char buf[MAXBUFFLEN + 1];
+    BufferWrite(buffer, buf, FormatFloat2(buf, f));
+}
+
+void
+FlushBuffer(ACBuffer* buffer)
+{
+    if (!buffer || !buffer->writeCB || buffer->length == 0)
+        return;
+
+    buffer->writeCB(buffer->userData, buffer->data, buffer->length);
+    buffer->length = 0;
+}
+
+size_t
+FormatInt(char* buf, int32_t i)
+{
+    char digits[10];
+    size_t n = 0, len = 0;
+    uint32_t u = i < 0 ? 0u - (uint32_t)i : (uint32_t)i;
+
+    if (i < 0)
+        buf[len++] = '-';
+    do {
+        digits[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    while (n > 0)
+        buf[len++] = digits[--n];
+    buf[len++] = ' ';
+    buf[len] = '\0';
+
+    return len;
+}
+
+size_t
+FormatFloat2(char* buf, float f)
+{
+    float r = roundf(f * 100);
+    uint32_t u;
+    size_t len = 0;
+
+    /* Above this, r / 100 is not always printed as r with the decimal point
+     * moved, as the float nearest to it may be more than 0.005 away. */
+    if (!(fabsf(r) < 6553600))
+        return (size_t)snprintf(buf, MAXBUFFLEN, "%0.2f ", r / 100);
+
+    /* A negative value rounded to 0 is printed as "-0.00" by printf(). */
+    if (signbit(r))
+        buf[len++] = '-';
+    u = (uint32_t)fabsf(r);
+    len += FormatInt(buf + len, (int32_t)(u / 100)) - 1;
+    buf[len++] = '.';
+    buf[len++] = (char)('0' + u % 100 / 10);
+    buf[len++] = (char)('0' + u % 10);
+    buf[len++] = ' ';
+    buf[len] = '\0';
+
+    return len;
+}
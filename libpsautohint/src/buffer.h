@@ -0,0 +1,52 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Growable output buffers, used to write the hinted glyphs. */
+
+#ifndef AC_BUFFER_H_
+#define AC_BUFFER_H_
+
+#include "psautohint.h"
+
+#include "basic.h"
+
+/* When writeCB is set, the buffer is a fixed size staging area whose content
+ * is passed to writeCB whenever it fills up, instead of growing. */
+typedef struct {
+  char* data;       /* glyph data held in the buffer */
+  size_t length;    /* actual length of the data */
+  size_t capacity;  /* allocated memory size */
+  AC_WRITEFUNCPTR writeCB;
+  void* userData;   /* passed to writeCB */
+} ACBuffer;
+
+/* Returns a new empty buffer of the given capacity, or NULL if size is 0 or
+ * the memory could not be allocated. */
+ACBuffer* NewBuffer(size_t size);
+void FreeBuffer(ACBuffer* buffer);
+
+/* Append to the buffer, growing it geometrically so that writing a glyph
+ * stays linear in its size. The data is always kept NUL terminated, except
+ * for buffers with a writeCB. */
+void BufferWrite(ACBuffer* buffer, const char* str, size_t len);
+void BufferWriteString(ACBuffer* buffer, const char* str);
+/* Append a number followed by a space, formatted the same as "%d " and
+ * "%0.2f " of roundf(f * 100) / 100 respectively. */
+void BufferWriteInt(ACBuffer* buffer, int32_t i);
+void BufferWriteFloat2(ACBuffer* buffer, float f);
+/* Passes what is left in a buffer with a writeCB to it. */
+void FlushBuffer(ACBuffer* buffer);
+
+/* The formatters used by BufferWriteInt() and BufferWriteFloat2(). They write
+ * into buf, which must have room for MAXBUFFLEN + 1 characters, and return the
+ * length written. */
+size_t FormatInt(char* buf, int32_t i);
+size_t FormatFloat2(char* buf, float f);
+
+#endif /* AC_BUFFER_H_ */
@@ -7,8 +7,6 @@
  * This license is available at: http://opensource.org/licenses/Apache-2.0.
  */
 
-#include <stdarg.h>
-
 #include "ac.h"
 #include "bbox.h"
 #include "charpath.h"
@@ -18,7 +16,6 @@
 #define DONT_COMBINE_PATHS 1
 
 #define DMIN 50       /* device minimum (one-half of a device pixel) */
-#define GROWBUFF 2048 /* Amount to grow output buffer, if necessary. */
 #define FONTSTKLIMIT 22
 
 #define MAINHINTS -1
@@ -33,13 +30,12 @@
 #define FLATTEN 4
 #define GHOST 5
 
-static bool firstMT;
-static Cd* refPtArray = NULL;
-static char* outbuff;
-static int16_t masterCount;
-static const char** masterNames;
-static size_t byteCount, buffSize;
-static PathList* pathlist = NULL;
+static AC_THREAD_LOCAL bool firstMT;
+static AC_THREAD_LOCAL Cd* refPtArray = NULL;
+static AC_THREAD_LOCAL ACBuffer outbuff;
+static AC_THREAD_LOCAL int16_t masterCount;
+static AC_THREAD_LOCAL const char** masterNames;
+static AC_THREAD_LOCAL PathList* pathlist = NULL;
 static indx hintsMasterIx = 0; /* The index of the master we read hints from */
 
 /* Prototypes */
@@ -48,30 +44,22 @@ static int16_t GetOperandCount(int16_t);
 static void GetLengthandSubrIx(int16_t, int16_t*, int16_t*);
 
 /* macros */
-#define WRTNUM(i) WriteToBuffer("%d ", (int)(i))
-#define WRTNUMA(i) WriteToBuffer("%0.2f ", roundf((float)(i)*100) / 100)
-#define WriteStr(str) WriteToBuffer("%s ", str)
-#define WriteSubr(val) WriteToBuffer("%d subr ", val)
+#define WRTNUM(i) BufferWriteInt(&outbuff, (int32_t)(i))
+#define WRTNUMA(i) BufferWriteFloat2(&outbuff, (float)(i))
+#define WriteToBuffer(str) BufferWriteString(&outbuff, str)
 
-/* Checks if buffer needs to grow before writing out string. */
 static void
-WriteToBuffer(char* format, ...)
+WriteStr(const char* str)
 {
-    char outstr[MAXBUFFLEN + 1];
-    size_t len;
-    va_list va;
-
-    va_start(va, format);
-    len = vsnprintf(outstr, MAXBUFFLEN, format, va);
-    va_end(va);
-
-    if ((byteCount + len) > buffSize) {
-        buffSize += GROWBUFF;
-        outbuff = (char*)ReallocateMem(outbuff, buffSize, "file buffer");
-    }
+    WriteToBuffer(str);
+    WriteToBuffer(" ");
+}
 
-    sprintf(outbuff + byteCount, "%s", outstr);
-    byteCount += len;
+static void
+WriteSubr(int16_t val)
+{
+    WRTNUM(val);
+    WriteToBuffer("subr ");
 }
 
 static void
@@ -519,38 +507,38 @@ WriteSbandWidth(void)
         wsame = wsame && (pathlist[ix].width == pathlist[ix - 1].width);
     }
     if (sbsame && wsame) {
-        WriteToBuffer("%d %d ", pathlist[0].sb, pathlist[0].width);
+        WRTNUM(pathlist[0].sb);
+        WRTNUM(pathlist[0].width);
     } else if (sbsame) {
-        WriteToBuffer("%d ", pathlist[0].sb);
+        WRTNUM(pathlist[0].sb);
         for (j = 0; j < masterCount; j++) {
-            WriteToBuffer("%d ", (j == 0)
-                                   ? pathlist[j].width
-                                   : pathlist[j].width - pathlist[0].width);
+            WRTNUM((j == 0) ? pathlist[j].width
+                            : pathlist[j].width - pathlist[0].width);
         }
         GetLengthandSubrIx(1, &length, &subrix);
         WriteSubr(subrix);
     } else if (wsame) {
         for (j = 0; j < masterCount; j++) {
-            WriteToBuffer("%d ", (j == 0) ? pathlist[j].sb
-                                          : pathlist[j].sb - pathlist[0].sb);
+            WRTNUM((j == 0) ? pathlist[j].sb
+                            : pathlist[j].sb - pathlist[0].sb);
         }
         GetLengthandSubrIx(1, &length, &subrix);
         WriteSubr(subrix);
-        WriteToBuffer("%d ", pathlist[0].width);
+        WRTNUM(pathlist[0].width);
     } else {
         GetLengthandSubrIx(opcount, &length, &subrix);
         if ((writeSubrOnce = (length == opcount))) {
-            WriteToBuffer("%d %d ", pathlist[0].sb, pathlist[0].width);
+            WRTNUM(pathlist[0].sb);
+            WRTNUM(pathlist[0].width);
             length = startix = 1;
         }
         for (ix = 0; ix < opcount; ix += length) {
             for (j = startix; j < masterCount; j++) {
-                WriteToBuffer(
-                  "%d ", (ix == 0) ? (j == 0) ? pathlist[j].sb
-                                              : pathlist[j].sb - pathlist[0].sb
-                                   : (j == 0) ? (int32_t)pathlist[j].width
-                                              : (int32_t)(pathlist[j].width -
-                                                          pathlist[0].width));
+                WRTNUM((ix == 0) ? (j == 0) ? pathlist[j].sb
+                                            : pathlist[j].sb - pathlist[0].sb
+                                 : (j == 0) ? (int32_t)pathlist[j].width
+                                            : (int32_t)(pathlist[j].width -
+                                                        pathlist[0].width));
             }
             if (!writeSubrOnce || (ix == (opcount - 1)))
                 WriteSubr(subrix);
@@ -1377,7 +1365,8 @@ WriteFlex(indx eltix)
             } /* end of for opix */
         }     /* end of last else clause */
         if (j != 7) {
-            WriteToBuffer("%s 2 subr\n", GetOperator(optype));
+            WriteStr(GetOperator(optype));
+            WriteToBuffer("2 subr\n");
         }
         if (j == 7) {
             if (!ysame && (optype == HMT))
@@ -1386,6 +1375,7 @@ WriteFlex(indx eltix)
     } /* end of j for loop */
     WriteToBuffer("0 subr\n");
     UnallocateMem(refPtArray);
+    refPtArray = NULL;
 }
 
 static void
@@ -1728,11 +1718,13 @@ WritePaths(char** outBuffers, size_t* outLengths)
     for (mIx = 0; mIx < masterCount; mIx++) {
         PathList path = pathlist[mIx];
 
-        byteCount = 0;
-        buffSize = outLengths[mIx];
-        outbuff = outBuffers[mIx];
+        outbuff.data = outBuffers[mIx];
+        outbuff.capacity = outLengths[mIx];
+        outbuff.length = 0;
 
-        WriteToBuffer("%% %s\n", gGlyphName);
+        WriteToBuffer("% ");
+        WriteToBuffer(gGlyphName);
+        WriteToBuffer("\n");
 
         if (gAddHints && (pathlist[hintsMasterIx].mainhints != NULL))
             WriteUnmergedHints(MAINHINTS, mIx);
@@ -1764,8 +1756,8 @@ WritePaths(char** outBuffers, size_t* outLengths)
         }
         WriteToBuffer("ed\n");
 
-        outLengths[mIx] = byteCount;
-        outBuffers[mIx] = outbuff;
+        outLengths[mIx] = outbuff.length;
+        outBuffers[mIx] = outbuff.data;
     }
     return;
 #endif /* DONT_COMBINE_PATHS */
@@ -1773,7 +1765,9 @@ WritePaths(char** outBuffers, size_t* outLengths)
     /* The code below is not used, but were are not ifdef'ing it and the code
      * it calls so it keep compiling and does not bitrot. */
 
-    WriteToBuffer("%% %s\n", gGlyphName);
+    WriteToBuffer("% ");
+    WriteToBuffer(gGlyphName);
+    WriteToBuffer("\n");
 
     WriteSbandWidth();
     if (gAddHints && (pathlist[hintsMasterIx].mainhints != NULL))
@@ -2002,3 +1996,15 @@ MergeGlyphPaths(const ACFontInfo* fontinfo, const char** srcglyphs,
 
     return ok;
 }
+
+/* Releases the memory left allocated when an error interrupted
+ * MergeGlyphPaths(). */
+void
+CleanupGlyphPaths(void)
+{
+    if (pathlist != NULL)
+        FreePathElements(masterCount);
+
+    UnallocateMem(refPtArray);
+    refPtArray = NULL;
+}
@@ -35,8 +35,10 @@ typedef struct {
   int16_t width;
 } PathList;
 
-extern int32_t gPathEntries;  /* number of elements in a glyph path */
-extern bool gAddHints;  /* whether to include hints in the font */
+/* number of elements in a glyph path */
+extern AC_THREAD_LOCAL int32_t gPathEntries;
+/* whether to include hints in the font */
+extern AC_THREAD_LOCAL bool gAddHints;
 
 GlyphPathElt* AppendGlyphPathElement(int);
 
@@ -14,13 +14,15 @@
 #include "charpath.h"
 #include "memory.h"
 
-int32_t gPathEntries = 0; /* number of elements in a glyph path */
-bool gAddHints = true;    /* whether to include hints in the font */
+/* number of elements in a glyph path */
+AC_THREAD_LOCAL int32_t gPathEntries = 0;
+/* whether to include hints in the font */
+AC_THREAD_LOCAL bool gAddHints = true;
 
 #define MAXPATHELT 100 /* initial maximum number of path elements */
 
-static int32_t maxPathEntries = 0;
-static PathList* currPathList = NULL;
+static AC_THREAD_LOCAL int32_t maxPathEntries = 0;
+static AC_THREAD_LOCAL PathList* currPathList = NULL;
 
 static void CheckPath(void);
 
@@ -11,15 +11,15 @@
 
 /* number of default entries in counter hint glyph list. */
 #define COUNTERDEFAULTENTRIES 4
-#define COUNTERLISTSIZE 20
 
-char* gVHintList[] = { "m",  "M",  "T",  "ellipsis", NULL, NULL, NULL,
-                       NULL, NULL, NULL, NULL,       NULL, NULL, NULL,
-                       NULL, NULL, NULL, NULL,       NULL, NULL };
-char* gHHintList[] = { "element", "equivalence", "notelement", "divide", NULL,
-                       NULL,      NULL,          NULL,         NULL,     NULL,
-                       NULL,      NULL,          NULL,         NULL,     NULL,
-                       NULL,      NULL,          NULL,         NULL,     NULL };
+/* The counter hint glyphs of the font being hinted, set by ReadFontInfo(). */
+AC_THREAD_LOCAL char** gVHintList;
+AC_THREAD_LOCAL char** gHHintList;
+
+static char* VHintDefaults[COUNTERDEFAULTENTRIES] = { "m", "M", "T",
+                                                      "ellipsis" };
+static char* HHintDefaults[COUNTERDEFAULTENTRIES] = { "element", "equivalence",
+                                                      "notelement", "divide" };
 
 static char* UpperSpecialGlyphs[] = { "questiondown", "exclamdown", "semicolon",
                                       NULL };
@@ -43,40 +43,66 @@ FindNameInList(char* nm, char** lst)
     }
 }
 
+/* Fills the counter hint glyph lists with the default entries. */
+void
+InitCounterHintLists(char* HHintList[], char* VHintList[])
+{
+    int i;
+
+    for (i = 0; i < COUNTERLISTSIZE; i++) {
+        HHintList[i] = i < COUNTERDEFAULTENTRIES ? HHintDefaults[i] : NULL;
+        VHintList[i] = i < COUNTERDEFAULTENTRIES ? VHintDefaults[i] : NULL;
+    }
+}
+
 /* Adds specified glyphs to CounterHintList array. */
 int
-AddCounterHintGlyphs(char* charlist, char* HintList[])
+AddCounterHintGlyphs(const char* charlist, char* HintList[])
 {
     const char* setList = "(), \t\n\r";
+    const char* next = charlist;
     char* token;
-    bool firstTime = true;
+    size_t len;
     int16_t ListEntries = COUNTERDEFAULTENTRIES;
 
     while (true) {
-        if (firstTime) {
-            token = (char*)strtok(charlist, setList);
-            firstTime = false;
-        } else
-            token = (char*)strtok(NULL, setList);
-        if (token == NULL)
+        next += strspn(next, setList);
+        if (*next == '\0')
             break;
-        if (FindNameInList(token, HintList))
+        len = strcspn(next, setList);
+        token = AllocateMem(1, len + 1, "counter hints list");
+        strncpy(token, next, len);
+        next += len;
+        if (FindNameInList(token, HintList)) {
+            UnallocateMem(token);
             continue;
+        }
         /* Currently, HintList must end with a NULL pointer. */
         if (ListEntries == (COUNTERLISTSIZE - 1)) {
             LogMsg(WARNING, OK,
                    "Exceeded counter hints list size. (maximum is %d.) "
                    "Cannot add %s or subsequent characters.",
                    (int)COUNTERLISTSIZE, token);
+            UnallocateMem(token);
             break;
         }
-        HintList[ListEntries] =
-          AllocateMem(1, strlen(token) + 1, "counter hints list");
-        strcpy(HintList[ListEntries++], token);
+        HintList[ListEntries++] = token;
     }
     return (ListEntries - COUNTERDEFAULTENTRIES);
 }
 
+/* Releases the entries AddCounterHintGlyphs() added to HintList. */
+void
+FreeCounterHintGlyphs(char* HintList[])
+{
+    int i;
+
+    for (i = COUNTERDEFAULTENTRIES; i < COUNTERLISTSIZE; i++) {
+        UnallocateMem(HintList[i]);
+        HintList[i] = NULL;
+    }
+}
+
 int32_t
 SpecialGlyphType(void)
 {
@@ -0,0 +1,1112 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Type 2 charstring input and output.
+ *
+ * DecodeCharstring() turns a charstring into a path, see
+ * AC_DecodeCharstring(). The result is the same outline the Python
+ * T2ToBezExtractor writes as bez: flex is turned into two curves, every
+ * subpath is closed, and the hints are skipped.
+ *
+ * SaveCharstring() writes the hinted glyph as a charstring, see
+ * AutoHintCharstring(). It is the charstring the Python convertBezToT2()
+ * builds from the bez SaveFile() writes, so numbers are taken with the
+ * precision they have in bez. */
+
+#include "ac.h"
+
+#define T2STACKLIMIT 48
+/* The stems of each direction that are kept, as in convertBezToT2(). */
+#define T2HINTLIMIT 22
+#define T2SUBRDEPTH 10
+
+/* Type 2 operators, see the Type 2 Charstring Format specification. */
+#define T2HSTEM 1
+#define T2VSTEM 3
+#define T2VMOVETO 4
+#define T2RLINETO 5
+#define T2HLINETO 6
+#define T2VLINETO 7
+#define T2RRCURVETO 8
+#define T2CALLSUBR 10
+#define T2RETURN 11
+#define T2ESCAPE 12
+#define T2ENDCHAR 14
+#define T2HSTEMHM 18
+#define T2HINTMASK 19
+#define T2CNTRMASK 20
+#define T2RMOVETO 21
+#define T2HMOVETO 22
+#define T2VSTEMHM 23
+#define T2RCURVELINE 24
+#define T2RLINECURVE 25
+#define T2VVCURVETO 26
+#define T2HHCURVETO 27
+#define T2SHORTINT 28
+#define T2CALLGSUBR 29
+#define T2VHCURVETO 30
+#define T2HVCURVETO 31
+#define T2FIXED 255
+
+/* Escaped operators, following T2ESCAPE. */
+#define T2HFLEX 34
+#define T2FLEX 35
+#define T2HFLEX1 36
+#define T2FLEX1 37
+
+typedef struct {
+    const ACSubrs* localSubrs;
+    const ACSubrs* globalSubrs;
+    bool allowDecimals;
+
+    double stack[T2STACKLIMIT];
+    int nargs;
+    int nhints;
+    size_t maskBytes; /* 0 until the first hintmask or cntrmask */
+    bool gotWidth, hasWidth;
+    double width;
+    bool sawMoveTo, ended;
+    double x, y;
+
+    /* The path being built. */
+    unsigned char* ops;
+    int nops, opsSize;
+    int* coords;
+    int ncoords, coordsSize;
+} T2Decoder;
+
+/* The path coordinates are rounded as when they are written to bez and read
+ * back, so that hinting them gives the same result. */
+static int
+T2Coord(T2Decoder* t2, double v)
+{
+    char buf[MAXBUFFLEN + 1];
+    float r;
+
+    if (!t2->allowDecimals)
+        return FixInt((int32_t)rint(v));
+
+    /* See ParseString() in read.c. */
+    snprintf(buf, sizeof(buf), "%.2f", v);
+    r = (float)strtod(buf, NULL);
+    r = roundf(r * 100) / 100;
+    return FixReal(r);
+}
+
+static bool
+T2AddOp(T2Decoder* t2, unsigned char op, int n)
+{
+    if (t2->nops == t2->opsSize) {
+        int size = NUMMAX(t2->opsSize * 2, 64);
+        unsigned char* ops = ReallocateMem(t2->ops, size, "path operators");
+        if (!ops)
+            return false;
+        t2->ops = ops;
+        t2->opsSize = size;
+    }
+    if (t2->ncoords + n > t2->coordsSize) {
+        int size = NUMMAX(t2->coordsSize * 2, 256);
+        int* coords =
+          ReallocateMem(t2->coords, size * sizeof(int), "path coordinates");
+        if (!coords)
+            return false;
+        t2->coords = coords;
+        t2->coordsSize = size;
+    }
+    t2->ops[t2->nops++] = op;
+    return true;
+}
+
+static bool
+T2MoveTo(T2Decoder* t2, double dx, double dy)
+{
+    if (!T2AddOp(t2, AC_MOVETO, 2))
+        return false;
+    t2->x += dx;
+    t2->y += dy;
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->x);
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->y);
+    t2->sawMoveTo = true;
+    return true;
+}
+
+static bool
+T2LineTo(T2Decoder* t2, double dx, double dy)
+{
+    if (!t2->sawMoveTo && !T2MoveTo(t2, 0, 0))
+        return false;
+    if (!T2AddOp(t2, AC_LINETO, 2))
+        return false;
+    t2->x += dx;
+    t2->y += dy;
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->x);
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->y);
+    return true;
+}
+
+static bool
+T2CurveTo(T2Decoder* t2, double dx1, double dy1, double dx2, double dy2,
+          double dx3, double dy3)
+{
+    if (!t2->sawMoveTo && !T2MoveTo(t2, 0, 0))
+        return false;
+    if (!T2AddOp(t2, AC_CURVETO, 6))
+        return false;
+    t2->x += dx1;
+    t2->y += dy1;
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->x);
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->y);
+    t2->x += dx2;
+    t2->y += dy2;
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->x);
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->y);
+    t2->x += dx3;
+    t2->y += dy3;
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->x);
+    t2->coords[t2->ncoords++] = T2Coord(t2, t2->y);
+    return true;
+}
+
+/* In Type 2 every subpath is closed. */
+static bool
+T2EndPath(T2Decoder* t2)
+{
+    if (!t2->sawMoveTo)
+        return true;
+    t2->sawMoveTo = false;
+    return T2AddOp(t2, AC_CLOSEPATH, 0);
+}
+
+/* Takes the width off the arguments of the first stack clearing operator,
+ * which has it when their count does not have the expected parity. */
+static double*
+T2PopWidth(T2Decoder* t2, int evenOdd)
+{
+    double* args = t2->stack;
+
+    if (!t2->gotWidth) {
+        if ((t2->nargs % 2) != evenOdd && t2->nargs > 0) {
+            t2->width = args[0];
+            t2->hasWidth = true;
+            args++;
+            t2->nargs--;
+        }
+        t2->gotWidth = true;
+    }
+    return args;
+}
+
+/* The curve operators taking alternating horizontal and vertical tangents,
+ * hvcurveto and vhcurveto. */
+static bool
+T2AlternatingCurves(T2Decoder* t2, bool horizontal)
+{
+    double* a = t2->stack;
+    int n = t2->nargs;
+
+    while (n >= 4) {
+        double last = n == 5 ? a[4] : 0;
+        bool ok;
+        if (horizontal)
+            ok = T2CurveTo(t2, a[0], 0, a[1], a[2], last, a[3]);
+        else
+            ok = T2CurveTo(t2, 0, a[0], a[1], a[2], a[3], last);
+        if (!ok)
+            return false;
+        a += n == 5 ? 5 : 4;
+        n -= n == 5 ? 5 : 4;
+        horizontal = !horizontal;
+    }
+    return n == 0;
+}
+
+static bool
+T2Flex(T2Decoder* t2, int op)
+{
+    double* a = t2->stack;
+    double dx, dy;
+
+    switch (op) {
+        case T2FLEX:
+            if (t2->nargs != 13)
+                return false;
+            return T2CurveTo(t2, a[0], a[1], a[2], a[3], a[4], a[5]) &&
+                   T2CurveTo(t2, a[6], a[7], a[8], a[9], a[10], a[11]);
+        case T2HFLEX:
+            if (t2->nargs != 7)
+                return false;
+            return T2CurveTo(t2, a[0], 0, a[1], a[2], a[3], 0) &&
+                   T2CurveTo(t2, a[4], 0, a[5], -a[2], a[6], 0);
+        case T2HFLEX1:
+            if (t2->nargs != 9)
+                return false;
+            return T2CurveTo(t2, a[0], a[1], a[2], a[3], a[4], 0) &&
+                   T2CurveTo(t2, a[5], 0, a[6], a[7], a[8],
+                             -(a[1] + a[3] + a[7]));
+        case T2FLEX1:
+            if (t2->nargs != 11)
+                return false;
+            dx = a[0] + a[2] + a[4] + a[6] + a[8];
+            dy = a[1] + a[3] + a[5] + a[7] + a[9];
+            if (fabs(dx) > fabs(dy))
+                return T2CurveTo(t2, a[0], a[1], a[2], a[3], a[4], a[5]) &&
+                       T2CurveTo(t2, a[6], a[7], a[8], a[9], a[10], -dy);
+            return T2CurveTo(t2, a[0], a[1], a[2], a[3], a[4], a[5]) &&
+                   T2CurveTo(t2, a[6], a[7], a[8], a[9], -dx, a[10]);
+        default:
+            /* The arithmetic and storage operators are not supported. */
+            return false;
+    }
+}
+
+static const unsigned char*
+T2Subr(const ACSubrs* subrs, double index, size_t* length)
+{
+    int bias, i;
+
+    if (!subrs || subrs->count <= 0)
+        return NULL;
+
+    if (subrs->count < 1240)
+        bias = 107;
+    else if (subrs->count < 33900)
+        bias = 1131;
+    else
+        bias = 32768;
+
+    i = (int)index + bias;
+    if (i < 0 || i >= subrs->count)
+        return NULL;
+
+    *length = subrs->lengths[i];
+    return subrs->data[i];
+}
+
+/* Interprets a charstring or subroutine. Returns false if it is invalid or
+ * uses an unsupported operator. */
+static bool
+T2Execute(T2Decoder* t2, const unsigned char* cs, size_t length, int depth)
+{
+    const unsigned char* end = cs + length;
+    const unsigned char* subr;
+    size_t subrLength;
+    double* a;
+    int i, n;
+
+    if (depth > T2SUBRDEPTH)
+        return false;
+
+    while (cs < end && !t2->ended) {
+        int b0 = *cs++;
+
+        /* Operands. */
+        if (b0 == T2SHORTINT || b0 >= 32) {
+            double v;
+            if (t2->nargs == T2STACKLIMIT)
+                return false;
+            if (b0 == T2SHORTINT) {
+                if (end - cs < 2)
+                    return false;
+                v = (int16_t)((cs[0] << 8) | cs[1]);
+                cs += 2;
+            } else if (b0 <= 246) {
+                v = b0 - 139;
+            } else if (b0 <= 250) {
+                if (cs == end)
+                    return false;
+                v = (b0 - 247) * 256 + *cs++ + 108;
+            } else if (b0 <= 254) {
+                if (cs == end)
+                    return false;
+                v = -(b0 - 251) * 256 - *cs++ - 108;
+            } else { /* T2FIXED, 16.16 */
+                if (end - cs < 4)
+                    return false;
+                v = (int32_t)(((uint32_t)cs[0] << 24) | ((uint32_t)cs[1] << 16) |
+                              ((uint32_t)cs[2] << 8) | cs[3]) /
+                    65536.0;
+                cs += 4;
+            }
+            t2->stack[t2->nargs++] = v;
+            continue;
+        }
+
+        a = t2->stack;
+        n = t2->nargs;
+        switch (b0) {
+            case T2HSTEM:
+            case T2VSTEM:
+            case T2HSTEMHM:
+            case T2VSTEMHM:
+                T2PopWidth(t2, 0);
+                t2->nhints += t2->nargs / 2;
+                break;
+            case T2HINTMASK:
+            case T2CNTRMASK:
+                if (t2->maskBytes == 0) {
+                    /* An implicit vstem may precede the first mask. */
+                    T2PopWidth(t2, 0);
+                    t2->nhints += t2->nargs / 2;
+                    t2->maskBytes = (t2->nhints + 7) / 8;
+                }
+                if ((size_t)(end - cs) < t2->maskBytes)
+                    return false;
+                cs += t2->maskBytes;
+                break;
+            case T2RMOVETO:
+                if (!T2EndPath(t2))
+                    return false;
+                a = T2PopWidth(t2, 0);
+                if (t2->nargs < 2 || !T2MoveTo(t2, a[0], a[1]))
+                    return false;
+                break;
+            case T2HMOVETO:
+            case T2VMOVETO:
+                if (!T2EndPath(t2))
+                    return false;
+                a = T2PopWidth(t2, 1);
+                if (t2->nargs < 1)
+                    return false;
+                if (!(b0 == T2HMOVETO ? T2MoveTo(t2, a[0], 0)
+                                      : T2MoveTo(t2, 0, a[0])))
+                    return false;
+                break;
+            case T2RLINETO:
+                for (i = 0; i + 1 < n; i += 2) {
+                    if (!T2LineTo(t2, a[i], a[i + 1]))
+                        return false;
+                }
+                break;
+            case T2HLINETO:
+            case T2VLINETO:
+                for (i = 0; i < n; i++) {
+                    bool horizontal = (i % 2 == 0) == (b0 == T2HLINETO);
+                    if (!(horizontal ? T2LineTo(t2, a[i], 0)
+                                     : T2LineTo(t2, 0, a[i])))
+                        return false;
+                }
+                break;
+            case T2RRCURVETO:
+                for (i = 0; i + 5 < n; i += 6) {
+                    if (!T2CurveTo(t2, a[i], a[i + 1], a[i + 2], a[i + 3],
+                                   a[i + 4], a[i + 5]))
+                        return false;
+                }
+                break;
+            case T2RCURVELINE:
+                if (n < 2)
+                    return false;
+                for (i = 0; i + 5 < n - 2; i += 6) {
+                    if (!T2CurveTo(t2, a[i], a[i + 1], a[i + 2], a[i + 3],
+                                   a[i + 4], a[i + 5]))
+                        return false;
+                }
+                if (!T2LineTo(t2, a[n - 2], a[n - 1]))
+                    return false;
+                break;
+            case T2RLINECURVE:
+                if (n < 6)
+                    return false;
+                for (i = 0; i + 1 < n - 6; i += 2) {
+                    if (!T2LineTo(t2, a[i], a[i + 1]))
+                        return false;
+                }
+                if (!T2CurveTo(t2, a[n - 6], a[n - 5], a[n - 4], a[n - 3],
+                               a[n - 2], a[n - 1]))
+                    return false;
+                break;
+            case T2VVCURVETO:
+            case T2HHCURVETO: {
+                double d1 = 0;
+                if (n % 2) {
+                    d1 = a[0];
+                    a++;
+                    n--;
+                }
+                for (i = 0; i + 3 < n; i += 4) {
+                    bool ok;
+                    if (b0 == T2VVCURVETO)
+                        ok = T2CurveTo(t2, d1, a[i], a[i + 1], a[i + 2], 0,
+                                       a[i + 3]);
+                    else
+                        ok = T2CurveTo(t2, a[i], d1, a[i + 1], a[i + 2],
+                                       a[i + 3], 0);
+                    if (!ok)
+                        return false;
+                    d1 = 0;
+                }
+                break;
+            }
+            case T2VHCURVETO:
+            case T2HVCURVETO:
+                if (!T2AlternatingCurves(t2, b0 == T2HVCURVETO))
+                    return false;
+                break;
+            case T2CALLSUBR:
+            case T2CALLGSUBR:
+                if (n < 1)
+                    return false;
+                subr = T2Subr(b0 == T2CALLSUBR ? t2->localSubrs
+                                               : t2->globalSubrs,
+                              a[n - 1], &subrLength);
+                if (!subr)
+                    return false;
+                t2->nargs--;
+                if (!T2Execute(t2, subr, subrLength, depth + 1))
+                    return false;
+                continue; /* the operands are left to the caller */
+            case T2RETURN:
+                return true;
+            case T2ENDCHAR:
+                if (!T2EndPath(t2))
+                    return false;
+                T2PopWidth(t2, 0);
+                /* seac composites are not supported. */
+                if (t2->nargs != 0)
+                    return false;
+                t2->ended = true;
+                break;
+            case T2ESCAPE:
+                if (cs == end || !T2Flex(t2, *cs++))
+                    return false;
+                break;
+            default:
+                return false;
+        }
+        t2->nargs = 0;
+    }
+    return true;
+}
+
+int
+DecodeCharstring(const char* name, const unsigned char* charstring,
+                 size_t length, const ACSubrs* localSubrs,
+                 const ACSubrs* globalSubrs, bool allowDecimals,
+                 ACPath** path, double* width, bool* hasWidth)
+{
+    T2Decoder t2;
+    ACPath* p;
+    char* pname = NULL;
+
+    *path = NULL;
+    memset(&t2, 0, sizeof(t2));
+    t2.localSubrs = localSubrs;
+    t2.globalSubrs = globalSubrs;
+    t2.allowDecimals = allowDecimals;
+
+    if (!T2Execute(&t2, charstring, length, 0) || !T2EndPath(&t2)) {
+        UnallocateMem(t2.ops);
+        UnallocateMem(t2.coords);
+        return AC_FatalError;
+    }
+
+    p = (ACPath*)AllocateMem(1, sizeof(ACPath), "path");
+    if (p && name) {
+        pname = AllocateMem(strlen(name) + 1, 1, "glyph name");
+        if (pname)
+            strcpy(pname, name);
+    }
+    if (!p || (name && !pname)) {
+        UnallocateMem(p);
+        UnallocateMem(t2.ops);
+        UnallocateMem(t2.coords);
+        return AC_MemoryError;
+    }
+
+    p->name = pname;
+    p->nops = t2.nops;
+    p->ops = t2.ops;
+    p->coords = t2.coords;
+    *path = p;
+    *hasWidth = t2.hasWidth;
+    *width = t2.width;
+
+    return AC_Success;
+}
+
+void
+FreePath(ACPath* path)
+{
+    if (!path)
+        return;
+
+    UnallocateMem((char*)path->name);
+    UnallocateMem((unsigned char*)path->ops);
+    UnallocateMem((int*)path->coords);
+    UnallocateMem(path);
+}
+
+/* A number of the output. Like the Python floats in convertBezToT2(), the
+ * ones taken from bez with decimals are written as 16.16 fixed even when
+ * they are integers. */
+typedef struct {
+    double v;
+    bool isFloat;
+} T2Num;
+
+typedef struct {
+    T2Num pos, width;
+} T2Stem;
+
+/* A range of T2Encoder.members, with the stems of a hint mask or of a stem3
+ * group. */
+typedef struct {
+    int first, count;
+    bool vertical; /* of a group */
+} T2Range;
+
+/* An operator of the path, or a hint mask when op is T2HINTMASK. */
+typedef struct {
+    int op;
+    int mask;
+    int nargs;
+    T2Num args[13];
+} T2Op;
+
+typedef struct {
+    /* The stems of each direction, [1] vertical, in the order found. */
+    T2Stem* stems[2];
+    int nstems[2];
+    int* sorted[2]; /* position of each stem once sorted, -1 if dropped */
+    int nkept[2];
+
+    T2Range* masks; /* masks[0] holds the initial hints */
+    int nmasks;
+    T2Range* groups;
+    int ngroups;
+    int* members; /* stem index * 2 + 1 for vertical stems */
+    int nmembers;
+    int* members3; /* same for the stem3 groups */
+    int nmembers3;
+
+    T2Op* ops;
+    int nops;
+    T2Num x, y;
+} T2Encoder;
+
+static T2Num
+T2Int(int32_t i)
+{
+    T2Num n;
+    n.v = i;
+    n.isFloat = false;
+    return n;
+}
+
+/* The value of f as write.c writes it to bez. */
+static T2Num
+T2Value(Fixed f)
+{
+    T2Num n;
+
+    if (FracPart(f) == 0)
+        return T2Int(FTrunc(f));
+
+    /* See FormatFloat2() in buffer.c. */
+    n.v = roundf((float)FIXED2FLOAT(f) * 100) / 100.0;
+    n.isFloat = true;
+    return n;
+}
+
+static T2Num
+T2Sub(T2Num a, T2Num b)
+{
+    T2Num n;
+    n.v = a.v - b.v;
+    n.isFloat = a.isFloat || b.isFloat;
+    return n;
+}
+
+static bool
+T2SameNum(T2Num a, T2Num b)
+{
+    return a.v == b.v && a.isFloat == b.isFloat;
+}
+
+static void
+T2WriteByte(int b)
+{
+    char c = (char)b;
+    BufferWrite(gBezOutput, &c, 1);
+}
+
+static void
+T2WriteFixed(int32_t f)
+{
+    char bytes[5];
+    bytes[0] = (char)T2FIXED;
+    bytes[1] = (char)((uint32_t)f >> 24);
+    bytes[2] = (char)((uint32_t)f >> 16);
+    bytes[3] = (char)((uint32_t)f >> 8);
+    bytes[4] = (char)f;
+    BufferWrite(gBezOutput, bytes, 5);
+}
+
+static void
+T2WriteNum(T2Num n)
+{
+    int32_t i;
+
+    if (n.isFloat) {
+        T2WriteFixed((int32_t)floor(n.v * 65536 + 0.5));
+        return;
+    }
+
+    i = (int32_t)n.v;
+    if (i >= -107 && i <= 107) {
+        T2WriteByte(i + 139);
+    } else if (i >= 108 && i <= 1131) {
+        i -= 108;
+        T2WriteByte((i >> 8) + 247);
+        T2WriteByte(i & 0xFF);
+    } else if (i >= -1131 && i <= -108) {
+        i = -i - 108;
+        T2WriteByte((i >> 8) + 251);
+        T2WriteByte(i & 0xFF);
+    } else if (i >= -32768 && i <= 32767) {
+        T2WriteByte(T2SHORTINT);
+        T2WriteByte((i >> 8) & 0xFF);
+        T2WriteByte(i & 0xFF);
+    } else {
+        T2WriteFixed((int32_t)((uint32_t)i << 16));
+    }
+}
+
+static void
+T2WriteStems(T2Encoder* t2, int vertical)
+{
+    const T2Stem* stems = t2->stems[vertical];
+    double last = 0;
+    int i, j;
+
+    for (j = 0; j < t2->nkept[vertical]; j++) {
+        T2Num pos, width;
+        for (i = 0; t2->sorted[vertical][i] != j; i++)
+            ;
+        /* Both relative to the previous stem, integers when they can be. */
+        pos.v = stems[i].pos.v - last;
+        pos.isFloat = pos.v != floor(pos.v);
+        width.v = stems[i].width.v;
+        width.isFloat = width.v != floor(width.v);
+        last = stems[i].pos.v + stems[i].width.v;
+        T2WriteNum(pos);
+        T2WriteNum(width);
+    }
+}
+
+static void
+T2AddMaskBit(T2Encoder* t2, unsigned char* mask, int member)
+{
+    int vertical = member & 1;
+    int i = t2->sorted[vertical][member >> 1];
+
+    if (i < 0)
+        return; /* dropped */
+    if (vertical)
+        i += t2->nkept[0];
+    mask[i / 8] |= 1 << (7 - i % 8);
+}
+
+static void
+T2WriteMask(T2Encoder* t2, int op, const int* members1, int count1,
+            const int* members2, int count2)
+{
+    unsigned char mask[(2 * T2HINTLIMIT + 7) / 8];
+    int i, nbytes = (t2->nkept[0] + t2->nkept[1] + 7) / 8;
+
+    memset(mask, 0, sizeof(mask));
+    for (i = 0; i < count1; i++)
+        T2AddMaskBit(t2, mask, members1[i]);
+    for (i = 0; i < count2; i++)
+        T2AddMaskBit(t2, mask, members2[i]);
+
+    T2WriteByte(op);
+    BufferWrite(gBezOutput, (const char*)mask, nbytes);
+}
+
+static int
+T2FindStem(T2Encoder* t2, int vertical, T2Num pos, T2Num width)
+{
+    T2Stem* stems = t2->stems[vertical];
+    int i;
+
+    /* Stems are told apart by value only. */
+    for (i = 0; i < t2->nstems[vertical]; i++) {
+        if (stems[i].pos.v == pos.v && stems[i].width.v == width.v)
+            return i;
+    }
+    stems[i].pos = pos;
+    stems[i].width = width;
+    t2->nstems[vertical]++;
+    return i;
+}
+
+/* Returns whether two hint sets, listed in sort order, would be written the
+ * same to bez. */
+static bool
+T2SameHints(HintPoint** pts1, int n1, HintPoint** pts2, int n2)
+{
+    int i;
+
+    if (n1 != n2)
+        return false;
+    for (i = 0; i < n1; i++) {
+        HintPoint* p1 = pts1[i];
+        HintPoint* p2 = pts2[i];
+        bool vertical = p1->c == 'y' || p1->c == 'm';
+        if (p1->c != p2->c || p1->p0 != p2->p0 || p1->p1 != p2->p1)
+            return false;
+        if (vertical && (!T2SameNum(T2Value(p1->x0), T2Value(p2->x0)) ||
+                         !T2SameNum(T2Value(p1->x1 - p1->x0),
+                                    T2Value(p2->x1 - p2->x0))))
+            return false;
+        if (!vertical && (!T2SameNum(T2Value(p1->y0), T2Value(p2->y0)) ||
+                          !T2SameNum(T2Value(p1->y1 - p1->y0),
+                                     T2Value(p2->y1 - p2->y0))))
+            return false;
+    }
+    return true;
+}
+
+static int
+T2SortHints(HintPoint* lst, HintPoint** pts)
+{
+    HintPoint* pt;
+    int n = 0;
+
+    ResetPntLst(lst);
+    while ((pt = NextPntLst(lst)) != NULL)
+        pts[n++] = pt;
+    return n;
+}
+
+/* Adds a hint set to the last mask. Consecutive hstem3 or vstem3 stems make
+ * a group, from which the counter masks are built. */
+static void
+T2AddHints(T2Encoder* t2, HintPoint** pts, int n)
+{
+    T2Range* mask = &t2->masks[t2->nmasks - 1];
+    char last = 0;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        HintPoint* pt = pts[i];
+        int vertical = pt->c == 'y' || pt->c == 'm';
+        int member;
+
+        if (vertical)
+            member = T2FindStem(t2, 1, T2Value(pt->x0),
+                                T2Value(pt->x1 - pt->x0));
+        else
+            member = T2FindStem(t2, 0, T2Value(pt->y0),
+                                T2Value(pt->y1 - pt->y0));
+        member = member * 2 + vertical;
+
+        for (j = 0; j < mask->count; j++) {
+            if (t2->members[mask->first + j] == member)
+                break;
+        }
+        if (j == mask->count) {
+            t2->members[t2->nmembers++] = member;
+            mask->count++;
+        }
+
+        if (pt->c == 'm' || pt->c == 'v') {
+            if (pt->c != last) {
+                T2Range* group = &t2->groups[t2->ngroups++];
+                group->first = t2->nmembers3;
+                group->count = 0;
+                group->vertical = vertical;
+            }
+            t2->members3[t2->nmembers3++] = member;
+            t2->groups[t2->ngroups - 1].count++;
+        }
+        last = pt->c;
+    }
+}
+
+/* The overlap test of checkStem3ArgsOverlap(). */
+#define T2NOOVERLAP 0
+#define T2OVERLAP 1
+#define T2MATCH 2
+
+static int
+T2GroupOverlap(T2Encoder* t2, const T2Range* g1, const T2Range* g2)
+{
+    const T2Stem* stems = t2->stems[g1->vertical];
+    int status = T2NOOVERLAP;
+    int i, j;
+
+    for (i = 0; i < g1->count; i++) {
+        const T2Stem* s1 = &stems[t2->members3[g1->first + i] >> 1];
+        double x0 = s1->pos.v, x1 = x0 + s1->width.v;
+        for (j = 0; j < g2->count; j++) {
+            const T2Stem* s2 = &stems[t2->members3[g2->first + j] >> 1];
+            double y0 = s2->pos.v, y1 = y0 + s2->width.v;
+            if (x0 == y0) {
+                if (x1 != y1)
+                    return T2OVERLAP;
+                status = T2MATCH;
+            } else if (x1 == y1) {
+                return T2OVERLAP;
+            } else if ((x0 > y0 && x0 < y1) || (x1 > y0 && x1 < y1)) {
+                return T2OVERLAP;
+            }
+        }
+    }
+    return status;
+}
+
+/* Writes a counter mask for each set of stem3 groups that match, see
+ * buildControlMaskList() in otfFont.py. */
+static void
+T2WriteCounterMasks(T2Encoder* t2)
+{
+    int(*cntr)[2];
+    int ncntr = 1, i, k, vertical;
+
+    cntr = (int(*)[2])Alloc((t2->ngroups + 1) * sizeof(*cntr));
+    cntr[0][0] = cntr[0][1] = -1;
+
+    for (vertical = 0; vertical < 2; vertical++) {
+        for (i = 0; i < t2->ngroups; i++) {
+            if (t2->groups[i].vertical != vertical)
+                continue;
+            for (k = 0; k < ncntr; k++) {
+                int g = cntr[k][vertical];
+                if (g < 0) {
+                    cntr[k][vertical] = i;
+                    break;
+                }
+                if (T2GroupOverlap(t2, &t2->groups[i], &t2->groups[g]) ==
+                    T2MATCH)
+                    break;
+            }
+            if (k == ncntr) {
+                cntr[ncntr][vertical] = i;
+                cntr[ncntr][!vertical] = -1;
+                ncntr++;
+            }
+        }
+    }
+
+    for (k = 0; k < ncntr; k++) {
+        const T2Range* h = cntr[k][0] >= 0 ? &t2->groups[cntr[k][0]] : NULL;
+        const T2Range* v = cntr[k][1] >= 0 ? &t2->groups[cntr[k][1]] : NULL;
+        T2WriteMask(t2, T2CNTRMASK, h ? &t2->members3[h->first] : NULL,
+                    h ? h->count : 0, v ? &t2->members3[v->first] : NULL,
+                    v ? v->count : 0);
+    }
+}
+
+static int
+T2CompareStems(const T2Stem* s1, const T2Stem* s2)
+{
+    if (s1->pos.v != s2->pos.v)
+        return s1->pos.v < s2->pos.v ? -1 : 1;
+    if (s1->width.v != s2->width.v)
+        return s1->width.v < s2->width.v ? -1 : 1;
+    return 0;
+}
+
+/* Sorts the stems of a direction, keeping at most T2HINTLIMIT of them. The
+ * stems are few, and all different. */
+static void
+T2SortStems(T2Encoder* t2, int vertical)
+{
+    const T2Stem* stems = t2->stems[vertical];
+    int n = t2->nstems[vertical];
+    int i, j;
+
+    t2->sorted[vertical] = (int*)Alloc(NUMMAX(n, 1) * sizeof(int));
+    for (i = 0; i < n; i++) {
+        int pos = 0;
+        for (j = 0; j < n; j++) {
+            if (T2CompareStems(&stems[j], &stems[i]) < 0)
+                pos++;
+        }
+        t2->sorted[vertical][i] = pos < T2HINTLIMIT ? pos : -1;
+    }
+    t2->nkept[vertical] = NUMMIN(n, T2HINTLIMIT);
+}
+
+static T2Op*
+T2AddOp2(T2Encoder* t2, int op)
+{
+    T2Op* o = &t2->ops[t2->nops++];
+    o->op = op;
+    o->nargs = 0;
+    return o;
+}
+
+/* Adds the arguments of a point relative to the current one. */
+static void
+T2AddPoint(T2Encoder* t2, T2Op* o, Fixed x, Fixed y)
+{
+    T2Num nx = T2Value(FRnd(x)), ny = T2Value(FRnd(y));
+    o->args[o->nargs++] = T2Sub(nx, t2->x);
+    o->args[o->nargs++] = T2Sub(ny, t2->y);
+    t2->x = nx;
+    t2->y = ny;
+}
+
+static bool
+T2IsFlex(PathElt* e, bool firstFlex)
+{
+    PathElt *e0, *e1;
+
+    if (firstFlex) {
+        e0 = e;
+        e1 = e->next;
+    } else {
+        e0 = e->prev;
+        e1 = e;
+    }
+    return e0 != NULL && e0->isFlex && e1 != NULL && e1->isFlex;
+}
+
+void
+SaveCharstring(void)
+{
+    T2Encoder t2;
+    PathElt* e;
+    PathElt* flex = NULL;
+    HintPoint **pts, **prev, **tmp;
+    bool hints = (gPathStart != NULL && gPathStart != gPathEnd);
+    int nelts = 0, nsets = 1, npts = 0, maxpts = 0, nprev = 0, n, i;
+
+    /* Everything is allocated with Alloc(), for this glyph only. */
+    for (e = gPathStart; e != NULL; e = e->next) {
+        nelts++;
+        if (hints && (e == gPathStart || e->newhints != 0)) {
+            n = CountPntLst(gPtLstArray[e->newhints]);
+            npts += n;
+            maxpts = NUMMAX(maxpts, n);
+            nsets++;
+        }
+    }
+
+    memset(&t2, 0, sizeof(t2));
+    npts = NUMMAX(npts, 1);
+    t2.stems[0] = (T2Stem*)Alloc(npts * sizeof(T2Stem));
+    t2.stems[1] = (T2Stem*)Alloc(npts * sizeof(T2Stem));
+    t2.masks = (T2Range*)Alloc(nsets * sizeof(T2Range));
+    t2.groups = (T2Range*)Alloc(npts * sizeof(T2Range));
+    t2.members = (int*)Alloc(npts * sizeof(int));
+    t2.members3 = (int*)Alloc(npts * sizeof(int));
+    t2.ops = (T2Op*)Alloc((nelts + nsets + 1) * sizeof(T2Op));
+    pts = (HintPoint**)Alloc(NUMMAX(maxpts, 1) * sizeof(HintPoint*));
+    prev = (HintPoint**)Alloc(NUMMAX(maxpts, 1) * sizeof(HintPoint*));
+    t2.x = t2.y = T2Int(0);
+
+    /* The initial hints, unless the first element starts a new set. */
+    t2.nmasks = 1;
+    if (hints && gPathStart->newhints == 0) {
+        nprev = T2SortHints(gPtLstArray[0], prev);
+        T2AddHints(&t2, prev, nprev);
+    }
+
+    for (e = gPathStart; e != NULL; e = e->next) {
+        T2Op* o;
+
+        /* The hint replacements, see wrtnewhints(). */
+        if (hints && e->newhints != 0) {
+            n = T2SortHints(gPtLstArray[e->newhints], pts);
+            if (!T2SameHints(pts, n, prev, nprev)) {
+                t2.masks[t2.nmasks].first = t2.nmembers;
+                t2.masks[t2.nmasks].count = 0;
+                T2AddOp2(&t2, T2HINTMASK)->mask = t2.nmasks++;
+                T2AddHints(&t2, pts, n);
+                tmp = prev;
+                prev = pts;
+                pts = tmp;
+                nprev = n;
+            }
+        }
+
+        switch (e->type) {
+            case MOVETO:
+            case LINETO:
+                o = T2AddOp2(&t2, e->type == MOVETO ? T2RMOVETO : T2RLINETO);
+                T2AddPoint(&t2, o, e->x, -e->y);
+                break;
+            case CURVETO:
+                /* The two curves of a flex, paired as in ct(). */
+                if (e->isFlex && T2IsFlex(e, flex == NULL)) {
+                    if (flex == NULL) {
+                        flex = e;
+                        break;
+                    }
+                    o = T2AddOp2(&t2, T2FLEX);
+                    T2AddPoint(&t2, o, flex->x1, -flex->y1);
+                    T2AddPoint(&t2, o, flex->x2, -flex->y2);
+                    T2AddPoint(&t2, o, flex->x3, -flex->y3);
+                    flex = NULL;
+                } else {
+                    o = T2AddOp2(&t2, T2RRCURVETO);
+                }
+                T2AddPoint(&t2, o, e->x1, -e->y1);
+                T2AddPoint(&t2, o, e->x2, -e->y2);
+                T2AddPoint(&t2, o, e->x3, -e->y3);
+                if (o->op == T2FLEX)
+                    o->args[o->nargs++] = T2Int(50);
+                break;
+            case CLOSEPATH:
+                break;
+            default:
+                LogMsg(LOGERROR, NONFATALERROR, "Illegal path list.");
+        }
+    }
+    T2AddOp2(&t2, T2ENDCHAR);
+
+    /* The stems, then the counter masks and the initial hint mask. */
+    T2SortStems(&t2, 0);
+    T2SortStems(&t2, 1);
+
+    if (gCharstringOutput->hasWidth) {
+        T2Num width;
+        width.v = gCharstringOutput->width;
+        width.isFloat = width.v != floor(width.v);
+        T2WriteNum(width);
+    }
+    if (t2.nkept[0] > 0) {
+        T2WriteStems(&t2, 0);
+        T2WriteByte(t2.nmasks > 1 ? T2HSTEMHM : T2HSTEM);
+    }
+    if (t2.nkept[1] > 0) {
+        T2WriteStems(&t2, 1);
+        /* vstemhm is implied by the hint mask that follows. */
+        if (t2.nmasks == 1)
+            T2WriteByte(T2VSTEM);
+    }
+    if (t2.ngroups > 0)
+        T2WriteCounterMasks(&t2);
+    if (t2.nmasks > 1 &&
+        !(t2.ops[0].op == T2HINTMASK && t2.ops[0].mask == 1))
+        T2WriteMask(&t2, T2HINTMASK, t2.members, t2.masks[0].count, NULL, 0);
+
+    for (i = 0; i < t2.nops; i++) {
+        T2Op* o = &t2.ops[i];
+        int j;
+        if (o->op == T2HINTMASK) {
+            const T2Range* mask = &t2.masks[o->mask];
+            T2WriteMask(&t2, T2HINTMASK, &t2.members[mask->first],
+                        mask->count, NULL, 0);
+            continue;
+        }
+        for (j = 0; j < o->nargs; j++)
+            T2WriteNum(o->args[j]);
+        if (o->op == T2FLEX) {
+            T2WriteByte(T2ESCAPE);
+            T2WriteByte(T2FLEX);
+        } else {
+            T2WriteByte(o->op);
+        }
+    }
+}
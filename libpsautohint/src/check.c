@@ -11,16 +11,16 @@
 
 #include "ac.h"
 
-static bool xflat, yflat, xdone, ydone, bbquit;
-static int32_t xstate, ystate, xstart, ystart;
-static Fixed x0, cy0, x1, cy1, xloc, yloc;
-static Fixed x, y, xnxt, ynxt;
-static Fixed yflatstartx, yflatstarty, yflatendx, yflatendy;
-static Fixed xflatstarty, xflatstartx, xflatendx, xflatendy;
-static bool vert, started, reCheckSmooth;
-static Fixed loc, frst, lst, fltnvalue;
-static PathElt* e;
-static bool forMultiMaster = false, inflPtFound = false;
+static AC_THREAD_LOCAL bool xflat, yflat, xdone, ydone, bbquit;
+static AC_THREAD_LOCAL int32_t xstate, ystate, xstart, ystart;
+static AC_THREAD_LOCAL Fixed x0, cy0, x1, cy1, xloc, yloc;
+static AC_THREAD_LOCAL Fixed x, y, xnxt, ynxt;
+static AC_THREAD_LOCAL Fixed yflatstartx, yflatstarty, yflatendx, yflatendy;
+static AC_THREAD_LOCAL Fixed xflatstarty, xflatstartx, xflatendx, xflatendy;
+static AC_THREAD_LOCAL bool vert, started, reCheckSmooth;
+static AC_THREAD_LOCAL Fixed loc, frst, lst, fltnvalue;
+static AC_THREAD_LOCAL PathElt* e;
+static AC_THREAD_LOCAL bool forMultiMaster = false, inflPtFound = false;
 
 #define STARTING (0)
 #define goingUP (1)
@@ -13,7 +13,9 @@
 static void DoHStems(const ACFontInfo* fontinfo, HintVal* sLst1);
 static void DoVStems(HintVal* sLst);
 
-static bool CounterFailed;
+static AC_THREAD_LOCAL bool CounterFailed;
+static AC_THREAD_LOCAL bool savedHasFlex;
+static AC_THREAD_LOCAL char savedGlyphName[MAX_GLYPHNAME_LEN];
 
 void
 InitAll(const ACFontInfo* fontinfo, int32_t reason)
@@ -416,7 +418,8 @@ Blues(const ACFontInfo* fontinfo)
 
      AddSegment is pretty simple. It creates a new hint segment 'HintSeg' for
     the parent path elt , fills it in, adds it to appropriate  list of the 4
-    segLists, and then sorts by hstem location. seg->sElt is the parent elt
+    segLists; GenHPts sorts the lists by hstem location once all segments
+    have been added. seg->sElt is the parent elt
      seg->sType is the type
      seg->sLoc is the location in Fixed 18.14: right shift 7 to get integer
     value.
@@ -610,7 +613,7 @@ DoHStems(const ACFontInfo* fontinfo, HintVal* sLst1)
 {
     Fixed glyphTop = INT32_MIN, glyphBot = INT32_MAX;
     bool curved;
-    if (!gDoAligns && !gDoStems) {
+    if (!gContext->doAligns && !gContext->doStems) {
         return;
     }
     while (sLst1 != NULL) {
@@ -714,7 +717,7 @@ Yellows(void)
 static void
 DoVStems(HintVal* sLst)
 {
-    if (!gDoAligns && !gDoStems) {
+    if (!gContext->doAligns && !gContext->doStems) {
         return;
     }
     while (sLst != NULL) {
@@ -785,19 +788,73 @@ AddHintsSetup(void)
     /* PreCheckForSolEol(); */
 }
 
+static bool
+ReadSource(const ACFontInfo* fontinfo, const ACGlyphSource* glyph)
+{
+    if (glyph->path != NULL)
+        return ReadGlyphPath(glyph->path);
+    return ReadGlyph(fontinfo, glyph->bez, false, false);
+}
+
+/* Copies the glyph path, as set up for hinting, to memory that InitAll()
+ * does not reset, so that hinting can be restarted without reading and
+ * setting up the glyph again. */
+static void
+SavePath(void)
+{
+    PathElt* e;
+    int32_t n = 0;
+    for (e = gPathStart; e != NULL; e = e->next)
+        n++;
+    if (n > gContext->savedPathSize) {
+        gContext->savedPath = (PathElt*)ReallocateMem(
+          gContext->savedPath, n * sizeof(PathElt), "saved glyph path");
+        gContext->savedPathSize = n;
+    }
+    n = 0;
+    for (e = gPathStart; e != NULL; e = e->next)
+        gContext->savedPath[n++] = *e;
+    gContext->savedPathLen = n;
+    savedHasFlex = gHasFlex;
+    strcpy(savedGlyphName, gGlyphName);
+}
+
+/* Rebuilds the glyph path saved by SavePath(). */
+static void
+RestorePath(void)
+{
+    int32_t i;
+    gPathStart = gPathEnd = NULL;
+    for (i = 0; i < gContext->savedPathLen; i++) {
+        PathElt* e = (PathElt*)Alloc(sizeof(PathElt));
+        *e = gContext->savedPath[i];
+        e->conflict = NULL;
+        e->Hs = e->Vs = NULL;
+        e->next = NULL;
+        e->prev = gPathEnd;
+        if (gPathEnd != NULL)
+            gPathEnd->next = e;
+        else
+            gPathStart = e;
+        gPathEnd = e;
+    }
+    gHasFlex = savedHasFlex;
+    strcpy(gGlyphName, savedGlyphName);
+}
+
 /* If extrahint is true then it is ok to have multi-level
  hinting. */
 static void
-AddHintsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
-                  bool extrahint)
+AddHintsInnerLoop(const ACFontInfo* fontinfo, bool extrahint)
 {
     int32_t retryHinting = 0;
+    SavePath();
     while (true) {
         PreGenPts();
         CheckSmooth();
         InitShuffleSubpaths();
         Blues(fontinfo);
-        if (!gDoAligns) {
+        if (!gContext->doAligns) {
             Yellows();
         }
         if (gEditGlyph) {
@@ -826,8 +883,8 @@ AddHintsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
     retry:
         /* if we are doing the stem and zones reporting, we need to discard the
          * reported. */
-        if (gReportRetryCB != NULL) {
-            gReportRetryCB();
+        if (gContext->reportRetryCB != NULL) {
+            gContext->reportRetryCB();
         }
         if (gPathStart == NULL || gPathStart == gPathEnd) {
             LogMsg(LOGERROR, NONFATALERROR, "No glyph path.");
@@ -836,17 +893,10 @@ AddHintsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
         /* SaveFile(); SaveFile is always called in AddHintsCleanup, so this is
          * a duplciate */
         InitAll(fontinfo, RESTART);
-        if (gWriteHintedBez && !ReadGlyph(fontinfo, srcglyph, false, false)) {
-            break;
-        }
-        AddHintsSetup();
-        if (!PreCheckForHinting()) {
-            break;
-        }
-        if (gFlexOK) {
-            gHasFlex = false;
-            AutoAddFlex();
-        }
+        /* Start over from the path as it was before hinting; reading the
+         * glyph again and redoing AddHintsSetup(), PreCheckForHinting() and
+         * AutoAddFlex() would give the same path. */
+        RestorePath();
     }
 }
 
@@ -867,7 +917,7 @@ AddHintsCleanup(const ACFontInfo* fontinfo)
 }
 
 static void
-AddHints(const ACFontInfo* fontinfo, const char* srcglyph, bool extrahint)
+AddHints(const ACFontInfo* fontinfo, bool extrahint)
 {
     if (gPathStart == NULL || gPathStart == gPathEnd) {
         LogMsg(INFO, OK, "No glyph path, so no hints.");
@@ -885,18 +935,19 @@ AddHints(const ACFontInfo* fontinfo, const char* srcglyph, bool extrahint)
         gHasFlex = false;
         AutoAddFlex();
     }
-    AddHintsInnerLoop(fontinfo, srcglyph, extrahint);
+    AddHintsInnerLoop(fontinfo, extrahint);
     AddHintsCleanup(fontinfo);
 }
 
 bool
-AutoHintGlyph(const ACFontInfo* fontinfo, const char* srcglyph, bool extrahint)
+AutoHintGlyph(const ACFontInfo* fontinfo, const ACGlyphSource* glyph,
+              bool extrahint)
 {
     int32_t lentop = gLenTopBands, lenbot = gLenBotBands;
-    if (!ReadGlyph(fontinfo, srcglyph, false, false)) {
+    if (!ReadSource(fontinfo, glyph)) {
         LogMsg(LOGERROR, NONFATALERROR, "Cannot parse glyph.");
     }
-    AddHints(fontinfo, srcglyph, extrahint);
+    AddHints(fontinfo, extrahint);
     gLenTopBands = lentop;
     gLenBotBands = lenbot;
     return true;
@@ -502,24 +502,47 @@ CombineValues(void)
     }
 }
 
+/* Widest pair separation that can still matter: AdjustVal gives a zero value
+   to any pair more than twice bigDist apart, and the near miss checks only
+   care about widths within 2 units of a known stem. */
+static Fixed
+PairWindow(Fixed bigDist, const Fixed* stems, int32_t numStems)
+{
+    Fixed window = 2 * bigDist;
+    int32_t i;
+    for (i = 0; i < numStems; i++) {
+        Fixed w = abs(stems[i]) + FixInt(2);
+        if (w > window)
+            window = w;
+    }
+    return window;
+}
+
 void
 EvalV(void)
 {
-    HintSeg *lList, *rList;
-    Fixed lft, rght;
+    HintSeg *lList, *rList, *rStart;
+    Fixed lft, rght, window;
     Fixed val, spc;
     gValList = NULL;
+    window = PairWindow(gVBigDist, gVStems, gNumVStems);
+    /* Both lists are sorted by sLoc, so sweep the right list with a window
+       that starts just past the current left segment. Pairs are visited in
+       the same order as a full cross product would visit them. */
+    rStart = rightList;
     lList = leftList;
     while (lList != NULL) {
-        rList = rightList;
+        lft = lList->sLoc;
+        while (rStart != NULL && rStart->sLoc <= lft)
+            rStart = rStart->sNxt;
+        rList = rStart;
         while (rList != NULL) {
-            lft = lList->sLoc;
             rght = rList->sLoc;
-            if (lft < rght) {
-                EvalVPair(lList, rList, &spc, &val);
-                VStemMiss(lList, rList);
-                AddVValue(lft, rght, val, spc, lList, rList);
-            }
+            if (rght - lft > window)
+                break;
+            EvalVPair(lList, rList, &spc, &val);
+            VStemMiss(lList, rList);
+            AddVValue(lft, rght, val, spc, lList, rList);
             rList = rList->sNxt;
         }
         lList = lList->sNxt;
@@ -530,22 +553,27 @@ EvalV(void)
 void
 EvalH(void)
 {
-    HintSeg *bList, *tList, *lst, *ghostSeg;
-    Fixed lstLoc, tempLoc, cntr;
+    HintSeg *bList, *tList, *tStart, *lst, *ghostSeg;
+    Fixed lstLoc, tempLoc, cntr, window;
     Fixed val, spc;
     gValList = NULL;
+    window = PairWindow(gHBigDist, gHStems, gNumHStems);
+    /* Same sweep as EvalV, with the window ending just before the current
+       bottom segment. */
+    tStart = topList;
     bList = botList;
     while (bList != NULL) {
-        tList = topList;
+        Fixed bot = bList->sLoc;
+        while (tStart != NULL && bot - tStart->sLoc > window)
+            tStart = tStart->sNxt;
+        tList = tStart;
         while (tList != NULL) {
-            Fixed bot, top;
-            bot = bList->sLoc;
-            top = tList->sLoc;
-            if (bot > top) {
-                EvalHPair(bList, tList, &spc, &val);
-                HStemMiss(bList, tList);
-                AddHValue(bot, top, val, spc, bList, tList);
-            }
+            Fixed top = tList->sLoc;
+            if (top >= bot)
+                break;
+            EvalHPair(bList, tList, &spc, &val);
+            HStemMiss(bList, tList);
+            AddHValue(bot, top, val, spc, bList, tList);
             tList = tList->sNxt;
         }
         bList = bList->sNxt;
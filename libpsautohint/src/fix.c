@@ -9,7 +9,7 @@
 
 #include "ac.h"
 
-static Fixed bPrev, tPrev;
+static AC_THREAD_LOCAL Fixed bPrev, tPrev;
 
 void
 InitFix(int32_t reason)
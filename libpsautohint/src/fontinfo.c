@@ -12,7 +12,7 @@
 
 #define UNDEFINED (INT32_MAX)
 
-int32_t gNumHHints, gNumVHints;
+AC_THREAD_LOCAL int32_t gNumHHints, gNumVHints;
 
 static void ParseIntStems(const ACFontInfo* fontinfo, char* kw, bool optional,
                           int32_t maxstems, int* stems, int32_t* pnum);
@@ -50,8 +50,8 @@ GetKeyFixedValue(const ACFontInfo* fontinfo, char* keyword, bool optional,
     }
 }
 
-bool
-ReadFontInfo(const ACFontInfo* fontinfo)
+void
+CompileFontInfo(ACFontInfo* fontinfo)
 {
     char* fontinfostr;
     int32_t AscenderHeight, AscenderOvershoot, BaselineYCoord,
@@ -60,6 +60,9 @@ ReadFontInfo(const ACFontInfo* fontinfo)
       DescenderOvershoot, FigHeight, FigOvershoot, Height5, Height5Overshoot,
       Height6, Height6Overshoot, LcHeight, LcOvershoot, OrdinalBaseline,
       OrdinalOvershoot, SuperiorBaseline, SuperiorOvershoot;
+    int32_t lentop = 0, lenbot = 0;
+    Fixed* top = fontinfo->topBands;
+    Fixed* bot = fontinfo->botBands;
     bool ORDINARYHINTING = gWriteHintedBez;
 
     AscenderHeight = AscenderOvershoot = BaselineYCoord = BaselineOvershoot =
@@ -69,34 +72,41 @@ ReadFontInfo(const ACFontInfo* fontinfo)
             Height6Overshoot = LcHeight = LcOvershoot = OrdinalBaseline =
               OrdinalOvershoot = SuperiorBaseline = SuperiorOvershoot =
                 UNDEFINED; /* mark as undefined */
-    gNumHStems = gNumVStems = 0;
-    gNumHHints = gNumVHints = 0;
-    gLenBotBands = gLenTopBands = 0;
+    fontinfo->numHStems = fontinfo->numVStems = 0;
+    fontinfo->numHHints = fontinfo->numVHints = 0;
+    fontinfo->lenBotBands = fontinfo->lenTopBands = 0;
 
     /* check for FlexOK, AuxHStems, AuxVStems */
     /* for intelligent scaling, it's too hard to check these */
-    ParseStems(fontinfo, "StemSnapH", gHStems, &gNumHStems);
-    ParseStems(fontinfo, "StemSnapV", gVStems, &gNumVStems);
-    if (gNumHStems == 0) {
-        ParseStems(fontinfo, "DominantH", gHStems, &gNumHStems);
-        ParseStems(fontinfo, "DominantV", gVStems, &gNumVStems);
+    ParseStems(fontinfo, "StemSnapH", fontinfo->hStems,
+               &fontinfo->numHStems);
+    ParseStems(fontinfo, "StemSnapV", fontinfo->vStems,
+               &fontinfo->numVStems);
+    if (fontinfo->numHStems == 0) {
+        ParseStems(fontinfo, "DominantH", fontinfo->hStems,
+                   &fontinfo->numHStems);
+        ParseStems(fontinfo, "DominantV", fontinfo->vStems,
+                   &fontinfo->numVStems);
     }
     fontinfostr = GetFontInfo(fontinfo, "FlexOK", !ORDINARYHINTING);
-    gFlexOK = strcmp(fontinfostr, "false");
+    fontinfo->flexOK = strcmp(fontinfostr, "false");
 
     fontinfostr = GetFontInfo(fontinfo, "FlexStrict", true);
-    gFlexStrict = strcmp(fontinfostr, "false");
+    fontinfo->flexStrict = strcmp(fontinfostr, "false");
 
-    /* get bluefuzz. It is already set to its default value in ac.c::InitData().
-    GetKeyFixedValue does not change the value if it's not present in fontinfo.
+    /* get bluefuzz. GetKeyFixedValue does not change the value if it's not
+    present in fontinfo, so set the default value first.
     */
-    GetKeyFixedValue(fontinfo, "BlueFuzz", OPTIONAL, &gBlueFuzz);
+    fontinfo->blueFuzz = DEFAULTBLUEFUZZ;
+    GetKeyFixedValue(fontinfo, "BlueFuzz", OPTIONAL, &fontinfo->blueFuzz);
 
     /* Check for counter hinting glyphs. */
     fontinfostr = GetFontInfo(fontinfo, "VCounterChars", OPTIONAL);
-    gNumVHints = AddCounterHintGlyphs(fontinfostr, gVHintList);
+    fontinfo->numVHints =
+      AddCounterHintGlyphs(fontinfostr, fontinfo->vHintList);
     fontinfostr = GetFontInfo(fontinfo, "HCounterChars", OPTIONAL);
-    gNumHHints = AddCounterHintGlyphs(fontinfostr, gHHintList);
+    fontinfo->numHHints =
+      AddCounterHintGlyphs(fontinfostr, fontinfo->hHintList);
 
     GetKeyValue(fontinfo, "AscenderHeight", OPTIONAL, &AscenderHeight);
     GetKeyValue(fontinfo, "AscenderOvershoot", OPTIONAL, &AscenderOvershoot);
@@ -124,57 +134,79 @@ ReadFontInfo(const ACFontInfo* fontinfo)
     GetKeyValue(fontinfo, "SuperiorBaseline", OPTIONAL, &SuperiorBaseline);
     GetKeyValue(fontinfo, "SuperiorOvershoot", OPTIONAL, &SuperiorOvershoot);
 
-    gLenBotBands = gLenTopBands = 0;
     if (BaselineYCoord != UNDEFINED && BaselineOvershoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] = FixInt(BaselineYCoord + BaselineOvershoot);
-        gBotBands[gLenBotBands++] = FixInt(BaselineYCoord);
+        bot[lenbot++] = FixInt(BaselineYCoord + BaselineOvershoot);
+        bot[lenbot++] = FixInt(BaselineYCoord);
     }
     if (Baseline5 != UNDEFINED && Baseline5Overshoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] = FixInt(Baseline5 + Baseline5Overshoot);
-        gBotBands[gLenBotBands++] = FixInt(Baseline5);
+        bot[lenbot++] = FixInt(Baseline5 + Baseline5Overshoot);
+        bot[lenbot++] = FixInt(Baseline5);
     }
     if (Baseline6 != UNDEFINED && Baseline6Overshoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] = FixInt(Baseline6 + Baseline6Overshoot);
-        gBotBands[gLenBotBands++] = FixInt(Baseline6);
+        bot[lenbot++] = FixInt(Baseline6 + Baseline6Overshoot);
+        bot[lenbot++] = FixInt(Baseline6);
     }
     if (SuperiorBaseline != UNDEFINED && SuperiorOvershoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] =
-          FixInt(SuperiorBaseline + SuperiorOvershoot);
-        gBotBands[gLenBotBands++] = FixInt(SuperiorBaseline);
+        bot[lenbot++] = FixInt(SuperiorBaseline + SuperiorOvershoot);
+        bot[lenbot++] = FixInt(SuperiorBaseline);
     }
     if (OrdinalBaseline != UNDEFINED && OrdinalOvershoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] = FixInt(OrdinalBaseline + OrdinalOvershoot);
-        gBotBands[gLenBotBands++] = FixInt(OrdinalBaseline);
+        bot[lenbot++] = FixInt(OrdinalBaseline + OrdinalOvershoot);
+        bot[lenbot++] = FixInt(OrdinalBaseline);
     }
     if (DescenderHeight != UNDEFINED && DescenderOvershoot != UNDEFINED) {
-        gBotBands[gLenBotBands++] =
-          FixInt(DescenderHeight + DescenderOvershoot);
-        gBotBands[gLenBotBands++] = FixInt(DescenderHeight);
+        bot[lenbot++] = FixInt(DescenderHeight + DescenderOvershoot);
+        bot[lenbot++] = FixInt(DescenderHeight);
     }
     if (CapHeight != UNDEFINED && CapOvershoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(CapHeight);
-        gTopBands[gLenTopBands++] = FixInt(CapHeight + CapOvershoot);
+        top[lentop++] = FixInt(CapHeight);
+        top[lentop++] = FixInt(CapHeight + CapOvershoot);
     }
     if (LcHeight != UNDEFINED && LcOvershoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(LcHeight);
-        gTopBands[gLenTopBands++] = FixInt(LcHeight + LcOvershoot);
+        top[lentop++] = FixInt(LcHeight);
+        top[lentop++] = FixInt(LcHeight + LcOvershoot);
     }
     if (AscenderHeight != UNDEFINED && AscenderOvershoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(AscenderHeight);
-        gTopBands[gLenTopBands++] = FixInt(AscenderHeight + AscenderOvershoot);
+        top[lentop++] = FixInt(AscenderHeight);
+        top[lentop++] = FixInt(AscenderHeight + AscenderOvershoot);
     }
     if (FigHeight != UNDEFINED && FigOvershoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(FigHeight);
-        gTopBands[gLenTopBands++] = FixInt(FigHeight + FigOvershoot);
+        top[lentop++] = FixInt(FigHeight);
+        top[lentop++] = FixInt(FigHeight + FigOvershoot);
     }
     if (Height5 != UNDEFINED && Height5Overshoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(Height5);
-        gTopBands[gLenTopBands++] = FixInt(Height5 + Height5Overshoot);
+        top[lentop++] = FixInt(Height5);
+        top[lentop++] = FixInt(Height5 + Height5Overshoot);
     }
     if (Height6 != UNDEFINED && Height6Overshoot != UNDEFINED) {
-        gTopBands[gLenTopBands++] = FixInt(Height6);
-        gTopBands[gLenTopBands++] = FixInt(Height6 + Height6Overshoot);
+        top[lentop++] = FixInt(Height6);
+        top[lentop++] = FixInt(Height6 + Height6Overshoot);
     }
+    fontinfo->lenTopBands = lentop;
+    fontinfo->lenBotBands = lenbot;
+}
+
+/* Sets the font-wide globals for hinting a glyph from the values compiled from
+ * the fontinfo. */
+bool
+ReadFontInfo(const ACFontInfo* fontinfo)
+{
+    memcpy(gTopBands, fontinfo->topBands, sizeof(gTopBands));
+    memcpy(gBotBands, fontinfo->botBands, sizeof(gBotBands));
+    gLenTopBands = fontinfo->lenTopBands;
+    gLenBotBands = fontinfo->lenBotBands;
+    memcpy(gHStems, fontinfo->hStems, sizeof(gHStems));
+    memcpy(gVStems, fontinfo->vStems, sizeof(gVStems));
+    gNumHStems = fontinfo->numHStems;
+    gNumVStems = fontinfo->numVStems;
+    gNumHHints = fontinfo->numHHints;
+    gNumVHints = fontinfo->numVHints;
+    gHHintList = (char**)fontinfo->hHintList;
+    gVHintList = (char**)fontinfo->vHintList;
+    gBlueFuzz = fontinfo->blueFuzz;
+    gFlexOK = fontinfo->flexOK;
+    gFlexStrict = fontinfo->flexStrict;
+
     return true;
 }
 
@@ -307,6 +339,9 @@ FreeFontInfo(ACFontInfo* fontinfo)
     if (!fontinfo)
         return;
 
+    FreeCounterHintGlyphs(fontinfo->hHintList);
+    FreeCounterHintGlyphs(fontinfo->vHintList);
+
     for (i = 0; i < fontinfo->length; i++) {
         if (fontinfo->values[i][0]) {
             UnallocateMem(fontinfo->values[i]);
@@ -361,6 +396,8 @@ NewFontInfo(void)
     for (i = 0; i < fontinfo->length; i++)
         fontinfo->values[i] = "";
 
+    InitCounterHintLists(fontinfo->hHintList, fontinfo->vHintList);
+
     return fontinfo;
 }
 
@@ -25,6 +25,7 @@
 #define DEFAULTBLUEFUZZ FixOne
 
 ACFontInfo* ParseFontInfo(const char* data);
+void CompileFontInfo(ACFontInfo* fontinfo);
 void FreeFontInfo(ACFontInfo* fontinfo);
 
 bool ReadFontInfo(const ACFontInfo* fontinfo);
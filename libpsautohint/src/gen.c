@@ -12,8 +12,8 @@
 #include "ac.h"
 #include "bbox.h"
 
-static SegLnkLst *Hlnks, *Vlnks;
-static int32_t cpFrom, cpTo;
+static AC_THREAD_LOCAL SegLnkLst *Hlnks, *Vlnks;
+static AC_THREAD_LOCAL int32_t cpFrom, cpTo;
 
 void
 InitGen(int32_t reason)
@@ -73,7 +73,7 @@ static void
 AddSegment(Fixed from, Fixed to, Fixed loc, int32_t lftLstNm, int32_t rghtLstNm,
            PathElt* e1, PathElt* e2, bool Hflg, int32_t typ)
 {
-    HintSeg *seg, *segList, *prevSeg;
+    HintSeg* seg;
     int32_t segNm;
     seg = (HintSeg*)Alloc(sizeof(HintSeg));
     seg->sLoc = loc;
@@ -100,28 +100,51 @@ AddSegment(Fixed from, Fixed to, Fixed loc, int32_t lftLstNm, int32_t rghtLstNm,
             seg->sElt = e2;
     }
     segNm = (from > to) ? lftLstNm : rghtLstNm;
-    segList = gSegLists[segNm];
-    prevSeg = NULL;
-    while (true) {             /* keep list in increasing order by sLoc */
-        if (segList == NULL) { /* at end of list */
-            if (prevSeg == NULL) {
-                gSegLists[segNm] = seg;
-                break;
-            }
-            prevSeg->sNxt = seg;
-            break;
-        }
-        if (segList->sLoc >= loc) { /* insert before this one */
-            if (prevSeg == NULL)
-                gSegLists[segNm] = seg;
-            else
-                prevSeg->sNxt = seg;
-            seg->sNxt = segList;
-            break;
+    /* Push onto the front of the list; SortSegLists puts the list in
+       increasing order by sLoc once all segments have been added. */
+    seg->sNxt = gSegLists[segNm];
+    gSegLists[segNm] = seg;
+}
+
+/* Stable merge sort of a segment list by sLoc. Segments are pushed in
+   reverse order, so equal sLoc values end up newest first, the same order
+   that inserting each segment before the first one with sLoc >= its own
+   used to give. */
+static HintSeg*
+SortSegList(HintSeg* lst)
+{
+    HintSeg *half, *fast, *head, **tail;
+    if (lst == NULL || lst->sNxt == NULL)
+        return lst;
+    half = lst;
+    fast = lst->sNxt;
+    while (fast != NULL && fast->sNxt != NULL) {
+        half = half->sNxt;
+        fast = fast->sNxt->sNxt;
+    }
+    fast = SortSegList(half->sNxt);
+    half->sNxt = NULL;
+    lst = SortSegList(lst);
+    tail = &head;
+    while (lst != NULL && fast != NULL) {
+        if (fast->sLoc < lst->sLoc) {
+            *tail = fast;
+            fast = fast->sNxt;
+        } else {
+            *tail = lst;
+            lst = lst->sNxt;
         }
-        prevSeg = segList;
-        segList = segList->sNxt;
+        tail = &(*tail)->sNxt;
     }
+    *tail = (lst != NULL) ? lst : fast;
+    return head;
+}
+
+static void
+SortSegLists(int32_t l0, int32_t l1)
+{
+    gSegLists[l0] = SortSegList(gSegLists[l0]);
+    gSegLists[l1] = SortSegList(gSegLists[l1]);
 }
 
 void
@@ -775,6 +798,7 @@ GenVPts(int32_t specialGlyphType)
         }
         p = p->next;
     }
+    SortSegLists(0, 1);
     CompactList(0, MergeVSegs);
     CompactList(1, MergeVSegs);
     RemExtraBends(0, 1);
@@ -995,6 +1019,7 @@ GenHPts(void)
         }
         p = p->next;
     }
+    SortSegLists(2, 3);
     CompactList(2, MergeHSegs);
     CompactList(3, MergeHSegs);
     RemExtraBends(2, 3);
@@ -11,38 +11,46 @@
 
 #include "ac.h"
 
-AC_REPORTFUNCPTR gLibReportCB = NULL;
+/* The functions themselves, not the AC_NO_DEBUG_LOGGING wrappers. */
+#undef LogMsg
+#undef LogEnabled
 
-/* proc to be called from LogMsg if error occurs */
-static int (*errorproc)(int16_t);
-
-void
-set_errorproc(int (*userproc)(int16_t))
+bool
+LogEnabled(int16_t level)
 {
-    errorproc = userproc;
+    return gContext != NULL && gContext->reportCB != NULL &&
+           level >= gContext->reportLevel;
 }
 
 void
 LogMsg(int16_t level, /* error, warning, info */
-       int16_t code,  /* exit value - if !OK, this proc will not return */
+       int16_t code,  /* exit value - if !OK, this proc will not return
+                        during a hinting call */
        char* format,  /* message string */
        ...)
 {
-    /* "glyphname: message" */
-    char str[MAX_GLYPHNAME_LEN + 2 + MAXMSGLEN + 1] = { 0 };
-    va_list va;
+    /* Messages below the report level are not even formatted. */
+    if (LogEnabled(level)) {
+        /* "glyphname: message" */
+        char str[MAX_GLYPHNAME_LEN + 2 + MAXMSGLEN + 1];
+        size_t len = 0;
+        va_list va;
 
-    if (strlen(gGlyphName) > 0)
-        snprintf(str, strlen(gGlyphName) + 3, "%s: ", gGlyphName);
+        if (gGlyphName[0] != '\0')
+            len = snprintf(str, sizeof(str), "%s: ", gGlyphName);
 
-    va_start(va, format);
-    vsnprintf(str + strlen(str), MAXMSGLEN, format, va);
-    va_end(va);
+        va_start(va, format);
+        vsnprintf(str + len, MAXMSGLEN, format, va);
+        va_end(va);
 
-    if (gLibReportCB != NULL)
-        gLibReportCB(str, level);
+        gContext->reportCB(str, level);
+    }
 
-    if (level == LOGERROR && (code == NONFATALERROR || code == FATALERROR)) {
-        (*errorproc)(code);
+    /* Abort the hinting call in progress on this thread; see the setjmp()
+     * calls in psautohint.c. Outside of a call there is nothing to abort and
+     * the caller deals with the error itself. */
+    if (level == LOGERROR && (code == NONFATALERROR || code == FATALERROR) &&
+        gContext != NULL) {
+        longjmp(gContext->mark, code);
     }
 }
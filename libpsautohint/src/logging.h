@@ -26,11 +26,22 @@
 /* maximum message length */
 #define MAXMSGLEN 500
 
-/* global log function which is supplied by the following */
-extern AC_REPORTFUNCPTR gLibReportCB;
-
 void LogMsg(int16_t, int16_t, char *, ...);
 
-void set_errorproc( int (*)(int16_t) );
+/* Whether messages of the given level are reported in the current context,
+ * see AC_SetReportLevel(). Code that only logs, like the loops dumping the
+ * hint values, checks it first. */
+bool LogEnabled(int16_t);
+
+/* Building with AC_NO_DEBUG_LOGGING drops the LOGDEBUG messages at compile
+ * time. LogMsg() is only ever called as a statement. */
+#ifdef AC_NO_DEBUG_LOGGING
+#define LogMsg(level, code, ...)                                               \
+    do {                                                                       \
+        if ((level) != LOGDEBUG)                                               \
+            (LogMsg)(level, code, __VA_ARGS__);                                \
+    } while (0)
+#define LogEnabled(level) ((level) != LOGDEBUG && (LogEnabled)(level))
+#endif
 
 #endif /* BF_LOGGING_H_ */
@@ -99,7 +99,7 @@ DoPrune(void)
     }
 }
 
-static HintVal*
+static void
 PruneOne(HintVal* sLst, bool hFlg, HintVal* sL, int32_t i)
 {
     /* Simply set the 'pruned' field to True for sLst. */
@@ -108,7 +108,6 @@ PruneOne(HintVal* sLst, bool hFlg, HintVal* sL, int32_t i)
     else
         ReportPruneVVal(sLst, sL, i);
     sLst->pruned = true;
-    return sLst->vNxt;
 }
 
 #define PRNDIST (PSDist(10))
@@ -133,42 +132,162 @@ PruneOne(HintVal* sLst, bool hFlg, HintVal* sL, int32_t i)
     (((val) < (FixedPosInf / VERYMUCHFCTR)) ? ((v) > (val)*VERYMUCHFCTR)       \
                                             : ((v) / VERYMUCHFCTR > (val)))
 
+typedef struct
+{
+    Fixed loc;
+    int32_t pos;
+} PruneKey;
+
+/* gValList indexed by location, so that each value is only compared with
+   the values that can prune it instead of with the whole list. */
+typedef struct
+{
+    HintVal** vals;   /* in list order */
+    PruneKey* byLoc1; /* list positions sorted by vLoc1 */
+    PruneKey* byLoc2; /* list positions sorted by vLoc2 */
+    int32_t* cands;
+    int32_t* stamp;
+    int32_t n;
+} PruneIndex;
+
+static int
+ComparePruneKeys(const void* a, const void* b)
+{
+    const PruneKey* k1 = (const PruneKey*)a;
+    const PruneKey* k2 = (const PruneKey*)b;
+    if (k1->loc != k2->loc)
+        return k1->loc < k2->loc ? -1 : 1;
+    return k1->pos < k2->pos ? -1 : k1->pos > k2->pos;
+}
+
+static int
+ComparePositions(const void* a, const void* b)
+{
+    int32_t p1 = *(const int32_t*)a, p2 = *(const int32_t*)b;
+    return p1 < p2 ? -1 : p1 > p2;
+}
+
+static void
+BuildPruneIndex(PruneIndex* ix)
+{
+    HintVal* vL;
+    int32_t n = 0;
+    for (vL = gValList; vL != NULL; vL = vL->vNxt)
+        n++;
+    ix->n = n;
+    ix->vals = (HintVal**)Alloc(NUMMAX(n, 1) * sizeof(HintVal*));
+    ix->byLoc1 = (PruneKey*)Alloc(NUMMAX(n, 1) * sizeof(PruneKey));
+    ix->byLoc2 = (PruneKey*)Alloc(NUMMAX(n, 1) * sizeof(PruneKey));
+    ix->cands = (int32_t*)Alloc(NUMMAX(n, 1) * sizeof(int32_t));
+    ix->stamp = (int32_t*)Alloc(NUMMAX(n, 1) * sizeof(int32_t));
+    n = 0;
+    for (vL = gValList; vL != NULL; vL = vL->vNxt) {
+        ix->vals[n] = vL;
+        ix->byLoc1[n].loc = vL->vLoc1;
+        ix->byLoc1[n].pos = n;
+        ix->byLoc2[n].loc = vL->vLoc2;
+        ix->byLoc2[n].pos = n;
+        ix->stamp[n] = -1;
+        n++;
+    }
+    qsort(ix->byLoc1, n, sizeof(PruneKey), ComparePruneKeys);
+    qsort(ix->byLoc2, n, sizeof(PruneKey), ComparePruneKeys);
+}
+
+/* Index of the first key with a location >= loc. */
+static int32_t
+FirstPruneKey(const PruneKey* keys, int32_t n, Fixed loc)
+{
+    int32_t lo = 0, hi = n;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if (keys[mid].loc < loc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void
+AddPruneCandidates(PruneIndex* ix, int32_t self, int32_t* pn,
+                   const PruneKey* keys, Fixed lo, Fixed hi)
+{
+    int32_t i;
+    for (i = FirstPruneKey(keys, ix->n, lo); i < ix->n && keys[i].loc <= hi;
+         i++) {
+        int32_t pos = keys[i].pos;
+        if (ix->stamp[pos] != self) {
+            ix->stamp[pos] = self;
+            ix->cands[(*pn)++] = pos;
+        }
+    }
+}
+
+/* Collects, in list order, the positions of the values that can prune the
+   value at position self, and returns their count. Since vLoc1 < vLoc2 for
+   vertical values and vLoc2 < vLoc1 for horizontal ones, these are the values
+   whose lower edge lies within the stem widened by PRNDIST, plus those whose
+   upper edge is within a unit of the stem's upper edge. Comparing with any
+   other value has no effect. */
+static int32_t
+PruneCandidates(PruneIndex* ix, int32_t self, bool hFlg)
+{
+    HintVal* sLst = ix->vals[self];
+    int32_t n = 0;
+    if (hFlg) {
+        AddPruneCandidates(ix, self, &n, ix->byLoc2, sLst->vLoc2 - PRNDIST,
+                           sLst->vLoc1 + PRNDIST);
+        AddPruneCandidates(ix, self, &n, ix->byLoc1,
+                           sLst->vLoc1 - FixOne + 1, sLst->vLoc1 + FixOne - 1);
+    } else {
+        AddPruneCandidates(ix, self, &n, ix->byLoc1, sLst->vLoc1 - PRNDIST,
+                           sLst->vLoc2 + PRNDIST);
+        AddPruneCandidates(ix, self, &n, ix->byLoc2,
+                           sLst->vLoc2 - FixOne + 1, sLst->vLoc2 + FixOne - 1);
+    }
+    qsort(ix->cands, n, sizeof(int32_t), ComparePositions);
+    return n;
+}
+
 /* The changes made here and in PruneHVals are to fix a bug in
  MinisterLight/E where the top left point was not getting hinted. */
 void
 PruneVVals(void)
 {
+    PruneIndex ix;
     HintVal *sLst, *sL;
     HintSeg *seg1, *seg2, *sg1, *sg2;
     Fixed lft, rht, l, r, prndist;
     Fixed val, v;
-    bool flg, otherLft, otherRht;
-    sLst = gValList;
+    bool otherLft, otherRht;
+    int32_t i, j, nCands;
+    BuildPruneIndex(&ix);
     prndist = PRNDIST;
-    while (sLst != NULL) {
-        flg = true;
+    for (i = 0; i < ix.n; i++) {
+        sLst = ix.vals[i];
         otherLft = otherRht = false;
         val = sLst->vVal;
         lft = sLst->vLoc1;
         rht = sLst->vLoc2;
         seg1 = sLst->vSeg1;
         seg2 = sLst->vSeg2;
-        sL = gValList;
-        while (sL != NULL) {
+        nCands = PruneCandidates(&ix, i, false);
+        for (j = 0; j < nCands; j++) {
+            sL = ix.vals[ix.cands[j]];
             v = sL->vVal;
             sg1 = sL->vSeg1;
             sg2 = sL->vSeg2;
             l = sL->vLoc1;
             r = sL->vLoc2;
             if ((l == lft && r == rht) || PruneLe(val, v))
-                goto NxtSL;
+                continue;
             if (rht + prndist >= r && lft - prndist <= l &&
                 (val < FixInt(100) && PruneMuchGt(val, v)
                    ? (CloseSegs(seg1, sg1, true) || CloseSegs(seg2, sg2, true))
                    : (CloseSegs(seg1, sg1, true) &&
                       CloseSegs(seg2, sg2, true)))) {
-                sLst = PruneOne(sLst, false, sL, 1);
-                flg = false;
+                PruneOne(sLst, false, sL, 1);
                 break;
             }
             if (seg1 != NULL && seg2 != NULL) {
@@ -178,8 +297,7 @@ PruneVVals(void)
                         CloseSegs(seg1, sg1, true))
                         otherLft = true;
                     if (seg2->sType == sBEND && CloseSegs(seg1, sg1, true)) {
-                        sLst = PruneOne(sLst, false, sL, 2);
-                        flg = false;
+                        PruneOne(sLst, false, sL, 2);
                         break;
                     }
                 }
@@ -189,22 +307,15 @@ PruneVVals(void)
                         CloseSegs(seg2, sg2, true))
                         otherRht = true;
                     if (seg1->sType == sBEND && CloseSegs(seg2, sg2, true)) {
-                        sLst = PruneOne(sLst, false, sL, 3);
-                        flg = false;
+                        PruneOne(sLst, false, sL, 3);
                         break;
                     }
                 }
                 if (otherLft && otherRht) {
-                    sLst = PruneOne(sLst, false, sL, 4);
-                    flg = false;
+                    PruneOne(sLst, false, sL, 4);
                     break;
                 }
             }
-        NxtSL:
-            sL = sL->vNxt;
-        }
-        if (flg) {
-            sLst = sLst->vNxt;
         }
     }
     DoPrune();
@@ -214,15 +325,17 @@ PruneVVals(void)
 void
 PruneHVals(void)
 {
+    PruneIndex ix;
     HintVal *sLst, *sL;
     HintSeg *seg1, *seg2, *sg1, *sg2;
     Fixed bot, top, t, b;
     Fixed val, v, prndist;
-    bool flg, otherTop, otherBot, topInBlue, botInBlue, ghst;
-    sLst = gValList;
+    bool otherTop, otherBot, topInBlue, botInBlue, ghst;
+    int32_t i, j, nCands;
+    BuildPruneIndex(&ix);
     prndist = PRNDIST;
-    while (sLst != NULL) {
-        flg = true;
+    for (i = 0; i < ix.n; i++) {
+        sLst = ix.vals[i];
         otherTop = otherBot = false;
         seg1 = sLst->vSeg1;
         seg2 = sLst->vSeg2; /* seg1 is bottom, seg2 is top */
@@ -232,16 +345,17 @@ PruneHVals(void)
         top = sLst->vLoc2;
         topInBlue = InBlueBand(top, gLenTopBands, gTopBands);
         botInBlue = InBlueBand(bot, gLenBotBands, gBotBands);
-        sL = gValList;
-        while (sL != NULL) {
-            if ((sL->pruned) && (gDoAligns || !gDoStems))
-                goto NxtSL;
+        nCands = PruneCandidates(&ix, i, true);
+        for (j = 0; j < nCands; j++) {
+            sL = ix.vals[ix.cands[j]];
+            if ((sL->pruned) && (gContext->doAligns || !gContext->doStems))
+                continue;
 
             sg1 = sL->vSeg1;
             sg2 = sL->vSeg2; /* sg1 is b, sg2 is t */
             v = sL->vVal;
             if (!ghst && sL->vGhst && !PruneVeryMuchGt(val, v))
-                goto NxtSL; /* Do not bother checking if we should prune, if
+                continue; /* Do not bother checking if we should prune, if
                                slSt is not ghost hint, sL is ghost hint,
                                          and not (sL->vVal is  more than 50*
                                bigger than sLst->vVal.
@@ -250,7 +364,7 @@ PruneHVals(void)
             b = sL->vLoc1;
             t = sL->vLoc2;
             if (t == top && b == bot)
-                goto NxtSL; /* Don't compare two valList elements that have the
+                continue; /* Don't compare two valList elements that have the
                                same top and bot. */
 
             if (/* Prune sLst if the following are all true */
@@ -278,13 +392,12 @@ PruneHVals(void)
                                                 and not in a blue zone. */
 
             ) {
-                sLst = PruneOne(sLst, true, sL, 5);
-                flg = false;
+                PruneOne(sLst, true, sL, 5);
                 break;
             }
 
             if (seg1 == NULL || seg2 == NULL)
-                goto NxtSL; /* If the sLst is aghost hint, skip  */
+                continue; /* If the sLst is aghost hint, skip  */
 
             if (abs(b - bot) < FixOne) {
                 /* If the bottoms of the stems are within 1 unit */
@@ -293,8 +406,7 @@ PruneHVals(void)
                     !topInBlue && seg2->sType == sBEND &&
                     CloseSegs(seg1, sg1, false) /* and the tops are close */
                 ) {
-                    sLst = PruneOne(sLst, true, sL, 6);
-                    flg = false;
+                    PruneOne(sLst, true, sL, 6);
                     break;
                 }
 
@@ -311,8 +423,7 @@ PruneHVals(void)
                     !botInBlue && seg2->sType == sBEND &&
                     CloseSegs(seg1, sg1, false)) /* and the tops are close */
                 {
-                    sLst = PruneOne(sLst, true, sL, 7);
-                    flg = false;
+                    PruneOne(sLst, true, sL, 7);
                     break;
                 }
 
@@ -327,15 +438,9 @@ PruneHVals(void)
                 /* if v less than  val by a factor of 3, and the sl stem width
                  is less than the sLst stem width,
                  and the tops and bottoms are close */
-                sLst = PruneOne(sLst, true, sL, 8);
-                flg = false;
+                PruneOne(sLst, true, sL, 8);
                 break;
             }
-        NxtSL:
-            sL = sL->vNxt;
-        }
-        if (flg) {
-            sLst = sLst->vNxt;
         }
     }
     DoPrune();
@@ -414,7 +519,7 @@ MergeVals(bool vert)
     FindBestVals(gValList);
     /* We want to get rid of wider hstems in favor or overlapping smaller hstems
      * only if we are NOT reporting all possible alignment zones. */
-    if (gAddStemExtremesCB == NULL)
+    if (gContext->addStemExtremesCB == NULL)
         return;
 
     for (vL = gValList; vL != NULL; vL = vL->vNxt)
@@ -10,7 +10,7 @@
 #include "ac.h"
 #include "bbox.h"
 
-static HintVal *Vrejects, *Hrejects;
+static AC_THREAD_LOCAL HintVal *Vrejects, *Hrejects;
 
 void
 InitPick(int32_t reason)
@@ -41,69 +41,277 @@ ConsiderPicking(Fixed bestSpc, Fixed bestVal, HintVal* hintList,
              : (prevBestVal / gPruneC <= bestVal);
 }
 
+/* The values still to be picked from. Values with a positive vSpc are
+   always worth picking; for the others ConsiderPicking only gets stricter as
+   vVal goes down. So keeping each kind in a heap ordered like the scan of
+   the value list, the next value to pick is at the top of one of the two
+   heaps. A max tree over the values sorted by the low end of their band
+   finds the values that overlap a picked one. */
+typedef struct
+{
+    HintVal* val;
+    Fixed lo, hi; /* band used for the overlap test */
+    bool alive;
+} PickItem;
+
+typedef struct
+{
+    Fixed loc;
+    int32_t item;
+} PickKey;
+
+typedef struct
+{
+    PickItem* items; /* in value list order */
+    int32_t n;
+    int32_t* heaps[2]; /* vSpc > 0, others */
+    int32_t heapLen[2];
+    PickKey* byLo;
+    int32_t* slot; /* index in byLo of each item */
+    Fixed* tree;   /* max hi of the living items in each range of byLo */
+    int32_t treeSize;
+    int32_t* found;
+} PickQueue;
+
+/* true iff item a would be picked before item b: it has a better value,
+   or an equal one and comes first in the value list. */
+static bool
+PickBefore(PickQueue* q, int32_t a, int32_t b)
+{
+    HintVal *va = q->items[a].val, *vb = q->items[b].val;
+    if (CompareValues(va, vb, spcBonus, 0))
+        return true;
+    return !CompareValues(vb, va, spcBonus, 0) && a < b;
+}
+
+static void
+PushPick(PickQueue* q, int32_t h, int32_t item)
+{
+    int32_t* heap = q->heaps[h];
+    int32_t i = q->heapLen[h]++;
+    while (i > 0) {
+        int32_t parent = (i - 1) / 2;
+        if (!PickBefore(q, item, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = item;
+}
+
+static void
+PopPick(PickQueue* q, int32_t h)
+{
+    int32_t* heap = q->heaps[h];
+    int32_t n = --q->heapLen[h];
+    int32_t item = heap[n];
+    int32_t i = 0;
+    while (true) {
+        int32_t child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && PickBefore(q, heap[child + 1], heap[child]))
+            child++;
+        if (!PickBefore(q, heap[child], item))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+/* Best living item of a heap, or -1. */
+static int32_t
+TopPick(PickQueue* q, int32_t h)
+{
+    while (q->heapLen[h] > 0 && !q->items[q->heaps[h][0]].alive)
+        PopPick(q, h);
+    return q->heapLen[h] > 0 ? q->heaps[h][0] : -1;
+}
+
+static int
+ComparePickKeys(const void* a, const void* b)
+{
+    const PickKey* k1 = (const PickKey*)a;
+    const PickKey* k2 = (const PickKey*)b;
+    if (k1->loc != k2->loc)
+        return k1->loc < k2->loc ? -1 : 1;
+    return k1->item < k2->item ? -1 : k1->item > k2->item;
+}
+
+static int
+ComparePickItems(const void* a, const void* b)
+{
+    int32_t i1 = *(const int32_t*)a, i2 = *(const int32_t*)b;
+    return i1 < i2 ? -1 : i1 > i2;
+}
+
+static void
+InitPickQueue(PickQueue* q, HintVal* valList, bool hFlg)
+{
+    HintVal* vlist;
+    int32_t i, n = 0, sz = 1;
+    for (vlist = valList; vlist != NULL; vlist = vlist->vNxt)
+        n++;
+    while (sz < n)
+        sz *= 2;
+    q->n = n;
+    q->items = (PickItem*)Alloc(sz * sizeof(PickItem));
+    q->heaps[0] = (int32_t*)Alloc(sz * sizeof(int32_t));
+    q->heaps[1] = (int32_t*)Alloc(sz * sizeof(int32_t));
+    q->heapLen[0] = q->heapLen[1] = 0;
+    q->byLo = (PickKey*)Alloc(sz * sizeof(PickKey));
+    q->slot = (int32_t*)Alloc(sz * sizeof(int32_t));
+    q->tree = (Fixed*)Alloc(2 * sz * sizeof(Fixed));
+    q->treeSize = sz;
+    q->found = (int32_t*)Alloc(sz * sizeof(int32_t));
+    for (i = 0, vlist = valList; vlist != NULL; i++, vlist = vlist->vNxt) {
+        PickItem* item = &q->items[i];
+        item->val = vlist;
+        item->alive = true;
+        if (hFlg) {
+            Fixed vbot = vlist->vLoc1, vtop = vlist->vLoc2;
+            /* ghost bands are given 0 width for the overlap test */
+            if (vlist->vGhst) {
+                if (vlist->vSeg1->sType == sGHOST)
+                    vbot = vtop;
+                else
+                    vtop = vbot;
+            }
+            item->lo = vtop;
+            item->hi = vbot;
+        } else {
+            item->lo = vlist->vLoc1;
+            item->hi = vlist->vLoc2;
+        }
+        PushPick(q, vlist->vSpc > 0 ? 0 : 1, i);
+        q->byLo[i].loc = item->lo;
+        q->byLo[i].item = i;
+    }
+    qsort(q->byLo, n, sizeof(PickKey), ComparePickKeys);
+    for (i = 0; i < sz; i++) {
+        if (i < n) {
+            q->slot[q->byLo[i].item] = i;
+            q->tree[sz + i] = q->items[q->byLo[i].item].hi;
+        } else
+            q->tree[sz + i] = FixedNegInf;
+    }
+    for (i = sz - 1; i > 0; i--)
+        q->tree[i] = NUMMAX(q->tree[2 * i], q->tree[2 * i + 1]);
+}
+
+static void
+RemovePick(PickQueue* q, int32_t item)
+{
+    int32_t i = q->treeSize + q->slot[item];
+    q->items[item].alive = false;
+    q->tree[i] = FixedNegInf;
+    for (i /= 2; i > 0; i /= 2)
+        q->tree[i] = NUMMAX(q->tree[2 * i], q->tree[2 * i + 1]);
+}
+
+/* The value PickVVals/PickHVals would find scanning the value list for the
+   best value ConsiderPicking accepts, or -1. */
+static int32_t
+NextPick(PickQueue* q, HintVal* hintList, Fixed prevBestVal)
+{
+    int32_t spc = TopPick(q, 0), other = TopPick(q, 1);
+    if (other >= 0 &&
+        !ConsiderPicking(q->items[other].val->vSpc, q->items[other].val->vVal,
+                         hintList, prevBestVal))
+        other = -1;
+    if (spc < 0 || (other >= 0 && PickBefore(q, other, spc)))
+        return other;
+    return spc;
+}
+
+static void
+CollectOverlaps(PickQueue* q, int32_t node, int32_t first, int32_t count,
+                int32_t end, Fixed minHi, int32_t* pn)
+{
+    if (first >= end || q->tree[node] < minHi)
+        return;
+    if (count == 1) {
+        q->found[(*pn)++] = q->byLo[first].item;
+        return;
+    }
+    count /= 2;
+    CollectOverlaps(q, 2 * node, first, count, end, minHi, pn);
+    CollectOverlaps(q, 2 * node + 1, first + count, count, end, minHi, pn);
+}
+
+/* Finds the living items with lo <= maxLo and hi >= minHi, in value list
+   order, and returns how many there are. */
+static int32_t
+FindOverlaps(PickQueue* q, Fixed maxLo, Fixed minHi)
+{
+    int32_t end = 0, last = q->n, n = 0;
+    while (end < last) { /* number of items with lo <= maxLo */
+        int32_t mid = end + (last - end) / 2;
+        if (q->byLo[mid].loc <= maxLo)
+            end = mid + 1;
+        else
+            last = mid;
+    }
+    CollectOverlaps(q, 1, 0, q->treeSize, end, minHi, &n);
+    qsort(q->found, n, sizeof(int32_t), ComparePickItems);
+    return n;
+}
+
+/* Moves the overlapping items to the front of rejectList, in value list
+   order. */
+static HintVal*
+RejectOverlaps(PickQueue* q, Fixed maxLo, Fixed minHi, HintVal* rejectList)
+{
+    int32_t i, n = FindOverlaps(q, maxLo, minHi);
+    for (i = 0; i < n; i++) {
+        HintVal* vlist = q->items[q->found[i]].val;
+        RemovePick(q, q->found[i]);
+        vlist->vNxt = rejectList;
+        rejectList = vlist;
+    }
+    return rejectList;
+}
+
+/* Moves the items that were not picked to the front of rejectList. */
+static HintVal*
+RejectRest(PickQueue* q, HintVal* rejectList)
+{
+    int32_t i;
+    for (i = 0; i < q->n; i++) {
+        if (q->items[i].alive) {
+            HintVal* vlist = q->items[i].val;
+            q->items[i].alive = false;
+            vlist->vNxt = rejectList;
+            rejectList = vlist;
+        }
+    }
+    return rejectList;
+}
+
 void
 PickVVals(HintVal* valList)
 {
-    HintVal *hintList, *rejectList, *vlist, *nxt;
-    Fixed bestVal = 0, prevBestVal;
+    PickQueue q;
+    HintVal *hintList, *rejectList;
+    Fixed prevBestVal;
+    int32_t b;
+    InitPickQueue(&q, valList, false);
     hintList = rejectList = NULL;
     prevBestVal = 0;
-    while (true) {
-        HintVal *prev, *bestPrev, *best;
+    while ((b = NextPick(&q, hintList, prevBestVal)) >= 0) {
+        HintVal* best = q.items[b].val;
         Fixed lft, rght;
-        vlist = valList;
-        prev = bestPrev = best = NULL;
-        while (vlist != NULL) {
-            if ((best == NULL || CompareValues(vlist, best, spcBonus, 0)) &&
-                ConsiderPicking(vlist->vSpc, vlist->vVal, hintList,
-                                prevBestVal)) {
-                best = vlist;
-                bestPrev = prev;
-                bestVal = vlist->vVal;
-            }
-            prev = vlist;
-            vlist = vlist->vNxt;
-        }
-        if (best == NULL)
-            break; /* no more */
-        if (bestPrev == NULL)
-            valList = best->vNxt;
-        else
-            bestPrev->vNxt = best->vNxt;
-        /* have now removed best from valList */
+        RemovePick(&q, b);
         best->vNxt = hintList; /* add best to front of list */
         hintList = best;
-        prevBestVal = bestVal;
+        prevBestVal = best->vVal;
         lft = best->vLoc1 - gBandMargin;
         rght = best->vLoc2 + gBandMargin;
         /* remove segments from valList that overlap lft..rght */
-        vlist = valList;
-        prev = NULL;
-        while (vlist != NULL) {
-            Fixed vlft = vlist->vLoc1;
-            Fixed vrght = vlist->vLoc2;
-            if ((vlft <= rght) && (vrght >= lft)) {
-                nxt = vlist->vNxt;
-                vlist->vNxt = rejectList;
-                rejectList = vlist;
-                vlist = nxt;
-                if (prev == NULL)
-                    valList = vlist;
-                else
-                    prev->vNxt = vlist;
-            } else {
-                prev = vlist;
-                vlist = vlist->vNxt;
-            }
-        }
-    }
-    vlist = valList; /* move rest of valList to rejectList */
-    while (vlist != NULL) {
-        nxt = vlist->vNxt;
-        vlist->vNxt = rejectList;
-        rejectList = vlist;
-        vlist = nxt;
+        rejectList = RejectOverlaps(&q, rght, lft, rejectList);
     }
+    rejectList = RejectRest(&q, rejectList);
     if (hintList == NULL)
         HintVBnds();
     gVHinting = hintList;
@@ -217,108 +425,76 @@ FindBestValForSeg(HintSeg* seg, bool seg1Flg, HintVal* cList, HintVal* rList,
     return best;
 }
 
-static bool
-MembValList(HintVal* val, HintVal* vList)
-{
-    while (vList != NULL) {
-        if (val == vList)
-            return true;
-        vList = vList->vNxt;
-    }
-    return false;
-}
-
-static HintVal*
-PrevVal(HintVal* val, HintVal* vList)
+/* Index of val among the items still to be picked, or -1. */
+static int32_t
+FindPick(PickQueue* q, HintVal* val)
 {
-    HintVal* prev;
-    if (val == vList)
-        return NULL;
-    prev = vList;
-    while (true) {
-        vList = vList->vNxt;
-        if (vList == NULL) {
-            LogMsg(LOGERROR, NONFATALERROR, "Malformed value list.");
-        }
-
-        if (vList == val)
-            return prev;
-        prev = vList;
+    int32_t i;
+    for (i = 0; i < q->n; i++) {
+        if (q->items[i].val == val)
+            return q->items[i].alive ? i : -1;
     }
+    return -1;
 }
 
 static void
-FindRealVal(HintVal* vlist, Fixed top, Fixed bot, HintSeg** pseg1,
+FindRealVal(PickQueue* q, Fixed top, Fixed bot, HintSeg** pseg1,
             HintSeg** pseg2)
 {
-    while (vlist != NULL) {
-        if (vlist->vLoc2 == top && vlist->vLoc1 == bot && !vlist->vGhst) {
+    int32_t i;
+    for (i = 0; i < q->n; i++) {
+        HintVal* vlist = q->items[i].val;
+        if (q->items[i].alive && vlist->vLoc2 == top && vlist->vLoc1 == bot &&
+            !vlist->vGhst) {
             *pseg1 = vlist->vSeg1;
             *pseg2 = vlist->vSeg2;
             return;
         }
-        vlist = vlist->vNxt;
     }
 }
 
 void
 PickHVals(HintVal* valList)
 {
-    HintVal *vlist, *hintList, *rejectList, *bestPrev, *prev, *best, *nxt;
+    PickQueue q;
+    HintVal *hintList, *rejectList, *best;
     Fixed bestVal, prevBestVal;
-    Fixed bot, top, vtop, vbot;
+    Fixed bot, top;
     HintVal* newBst;
     HintSeg *seg1, *seg2;
+    int32_t b, nb;
+    InitPickQueue(&q, valList, true);
     hintList = rejectList = NULL;
     prevBestVal = 0;
-    while (true) {
-        vlist = valList;
-        prev = bestPrev = best = NULL;
-        while (vlist != NULL) {
-            if ((best == NULL || CompareValues(vlist, best, spcBonus, 0)) &&
-                ConsiderPicking(vlist->vSpc, vlist->vVal, hintList,
-                                prevBestVal)) {
-                best = vlist;
-                bestPrev = prev;
-                bestVal = vlist->vVal;
-            }
-            prev = vlist;
-            vlist = vlist->vNxt;
+    while ((b = NextPick(&q, hintList, prevBestVal)) >= 0) {
+        best = q.items[b].val;
+        bestVal = best->vVal;
+        seg1 = best->vSeg1;
+        seg2 = best->vSeg2;
+        if (best->vGhst) { /* find float segments at same loc as best */
+            FindRealVal(&q, best->vLoc2, best->vLoc1, &seg1, &seg2);
         }
-        if (best != NULL) {
-            seg1 = best->vSeg1;
-            seg2 = best->vSeg2;
-            if (best->vGhst) { /* find float segments at same loc as best */
-                FindRealVal(valList, best->vLoc2, best->vLoc1, &seg1, &seg2);
+        if (seg1->sType == sGHOST) {
+            /*newBst = FindBestValForSeg(seg2, false, valList,
+             NULL, 0, (Fixed *)NIL, 0, (Fixed *)NIL, true);*/
+            newBst = seg2->sLnk;
+            if (newBst != NULL && newBst != best &&
+                (nb = FindPick(&q, newBst)) >= 0) {
+                best = newBst;
+                b = nb;
             }
-            if (seg1->sType == sGHOST) {
-                /*newBst = FindBestValForSeg(seg2, false, valList,
-                 NULL, 0, (Fixed *)NIL, 0, (Fixed *)NIL, true);*/
-                newBst = seg2->sLnk;
-                if (newBst != NULL && newBst != best &&
-                    MembValList(newBst, valList)) {
-                    best = newBst;
-                    bestPrev = PrevVal(best, valList);
-                }
-            } else if (seg2->sType == sGHOST) {
-                /*newBst = FindBestValForSeg(seg1, true, valList,
-                 NULL, 0, (Fixed *)NIL, 0, (Fixed *)NIL, true); */
-                newBst = seg2->sLnk;
-                if (newBst != NULL && newBst != best &&
-                    MembValList(newBst, valList)) {
-                    best = newBst;
-                    bestPrev = PrevVal(best, valList);
-                }
+        } else if (seg2->sType == sGHOST) {
+            /*newBst = FindBestValForSeg(seg1, true, valList,
+             NULL, 0, (Fixed *)NIL, 0, (Fixed *)NIL, true); */
+            newBst = seg2->sLnk;
+            if (newBst != NULL && newBst != best &&
+                (nb = FindPick(&q, newBst)) >= 0) {
+                best = newBst;
+                b = nb;
             }
         }
-        if (best == NULL)
-            goto noMore;
         prevBestVal = bestVal;
-        if (bestPrev == NULL)
-            valList = best->vNxt;
-        else
-            bestPrev->vNxt = best->vNxt;
-        /* have now removed best from valList */
+        RemovePick(&q, b);
         best->vNxt = hintList;
         hintList = best; /* add best to front of list */
         bot = best->vLoc1;
@@ -335,43 +511,9 @@ PickHVals(HintVal* valList)
         bot += gBandMargin;
         top -= gBandMargin;
         /* remove segments from valList that overlap bot..top */
-        vlist = valList;
-        prev = NULL;
-        while (vlist != NULL) {
-            vbot = vlist->vLoc1;
-            vtop = vlist->vLoc2;
-            /* The next if statement was added so that ghost bands are given
-             0 width for doing the conflict tests for bands too close together.
-             */
-            if (vlist->vGhst) { /* collapse width */
-                if (vlist->vSeg1->sType == sGHOST)
-                    vbot = vtop;
-                else
-                    vtop = vbot;
-            }
-            if ((vbot >= top) && (vtop <= bot)) {
-                nxt = vlist->vNxt;
-                vlist->vNxt = rejectList;
-                rejectList = vlist;
-                vlist = nxt;
-                if (prev == NULL)
-                    valList = vlist;
-                else
-                    prev->vNxt = vlist;
-            } else {
-                prev = vlist;
-                vlist = vlist->vNxt;
-            }
-        }
-    }
-noMore:
-    vlist = valList; /* move rest of valList to rejectList */
-    while (vlist != NULL) {
-        nxt = vlist->vNxt;
-        vlist->vNxt = rejectList;
-        rejectList = vlist;
-        vlist = nxt;
+        rejectList = RejectOverlaps(&q, bot, top, rejectList);
     }
+    rejectList = RejectRest(&q, rejectList);
     if (hintList == NULL)
         HintHBnds();
     gHHinting = hintList;
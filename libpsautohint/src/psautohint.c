@@ -7,51 +7,20 @@
  * This license is available at: http://opensource.org/licenses/Apache-2.0.
  */
 
-#include <setjmp.h>
-
 #include "ac.h"
 #include "fontinfo.h"
 #include "psautohint.h"
+#include "thread.h"
 #include "version.h"
 
-ACBuffer* gBezOutput = NULL;
-
-static jmp_buf aclibmark; /* to handle exit() calls in the library version*/
+AC_THREAD_LOCAL ACContext* gContext = NULL;
+AC_THREAD_LOCAL ACBuffer* gBezOutput = NULL;
+AC_THREAD_LOCAL ACHintResult* gHintResult = NULL;
+AC_THREAD_LOCAL const ACCharstringOutput* gCharstringOutput = NULL;
 
-static ACBuffer*
-NewBuffer(size_t size)
-{
-    ACBuffer* buffer;
-
-    if (size == 0)
-        return NULL;
-
-    buffer = (ACBuffer*)AllocateMem(1, sizeof(ACBuffer), "out buffer");
-    if (!buffer)
-        return NULL;
-
-    buffer->data = AllocateMem(size, 1, "out buffer data");
-    if (!buffer->data) {
-        UnallocateMem(buffer);
-        return NULL;
-    }
-
-    buffer->data[0] = '\0';
-    buffer->capacity = size;
-    buffer->length = 0;
-
-    return buffer;
-}
-
-static void
-FreeBuffer(ACBuffer* buffer)
-{
-    if (!buffer)
-        return;
-
-    UnallocateMem(buffer->data);
-    UnallocateMem(buffer);
-}
+/* The settings copied into every new context, see AC_NewContext(). */
+static ACContext defaultContext;
+static int defaultReportLevel = LOGDEBUG;
 
 ACLIB_API void
 AC_SetMemManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func)
@@ -62,127 +31,252 @@ AC_SetMemManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func)
 ACLIB_API void
 AC_SetReportCB(AC_REPORTFUNCPTR reportCB)
 {
-    gLibReportCB = reportCB;
+    defaultContext.reportCB = reportCB;
+}
+
+ACLIB_API void
+AC_SetReportLevel(int level)
+{
+    defaultReportLevel = level;
 }
 
 ACLIB_API void
 AC_SetReportStemsCB(AC_REPORTSTEMPTR hstemCB, AC_REPORTSTEMPTR vstemCB,
                     unsigned int allStems)
 {
-    gAllStems = allStems;
-    gAddHStemCB = hstemCB;
-    gAddVStemCB = vstemCB;
-    gDoStems = true;
-
-    gAddGlyphExtremesCB = NULL;
-    gAddStemExtremesCB = NULL;
-    gDoAligns = false;
+    defaultContext.allStems = allStems;
+    defaultContext.addHStemCB = hstemCB;
+    defaultContext.addVStemCB = vstemCB;
+    defaultContext.doStems = true;
+
+    defaultContext.addGlyphExtremesCB = NULL;
+    defaultContext.addStemExtremesCB = NULL;
+    defaultContext.doAligns = false;
 }
 
 ACLIB_API void
 AC_SetReportZonesCB(AC_REPORTZONEPTR glyphCB, AC_REPORTZONEPTR stemCB)
 {
-    gAddGlyphExtremesCB = glyphCB;
-    gAddStemExtremesCB = stemCB;
-    gDoAligns = true;
+    defaultContext.addGlyphExtremesCB = glyphCB;
+    defaultContext.addStemExtremesCB = stemCB;
+    defaultContext.doAligns = true;
 
-    gAddHStemCB = NULL;
-    gAddVStemCB = NULL;
-    gDoStems = false;
+    defaultContext.addHStemCB = NULL;
+    defaultContext.addVStemCB = NULL;
+    defaultContext.doStems = false;
 }
 
 ACLIB_API void
 AC_SetReportRetryCB(AC_RETRYPTR retryCB)
 {
-    gReportRetryCB = retryCB;
+    defaultContext.reportRetryCB = retryCB;
 }
 
-/*
- * This is our error handler, it gets called by LogMsg() whenever the log level
- * is LOGERROR (see logging.c for the exact condition). The call to longjmp()
- * will transfer the control to the point where setjmp() is called below. So
- * effectively whenever LogMsg() is called for an error the execution of the
- * calling function will end and we will return back to AutoHintString().
- */
-static int
-error_handler(int16_t code)
+ACLIB_API ACContext*
+AC_NewContext(void)
 {
-    if (code == FATALERROR || code == NONFATALERROR)
-        longjmp(aclibmark, -1);
-    else
-        longjmp(aclibmark, 1);
+    ACContext* context;
+
+    context = (ACContext*)AllocateMem(1, sizeof(ACContext), "context");
+    if (!context)
+        return NULL;
 
-    return 0; /* we don't actually ever get here */
+    *context = defaultContext;
+    context->reportLevel = defaultReportLevel;
+    context->vm = context->vmCurrent = NULL;
+    context->vmChunkSize = VMCHUNKSIZE;
+    context->savedPath = NULL;
+    context->savedPathLen = context->savedPathSize = 0;
+
+    return context;
 }
 
-ACLIB_API int
-AutoHintString(const char* srcbezdata, const char* fontinfodata,
-               char** dstbezdata, size_t* length, int allowEdit,
-               int allowHintSub, int roundCoords)
+ACLIB_API void
+AC_SetContextMemSize(ACContext* context, size_t size)
 {
-    int value, result;
-    ACFontInfo* fontinfo = NULL;
+    if (!context)
+        return;
 
-    if (!srcbezdata)
-        return AC_InvalidParameterError;
+    context->vmChunkSize = size > 0 ? size : VMCHUNKSIZE;
+}
 
-    fontinfo = ParseFontInfo(fontinfodata);
-    if (!fontinfo)
-        return AC_MemoryError;
+ACLIB_API void
+AC_SetContextReportLevel(ACContext* context, int level)
+{
+    if (!context)
+        return;
+
+    context->reportLevel = level;
+}
 
-    set_errorproc(error_handler);
-    value = setjmp(aclibmark);
+ACLIB_API void
+AC_FreeContext(ACContext* context)
+{
+    if (!context)
+        return;
 
-    /* We will return here whenever an error occurs during the execution of
-     * AutoHint(), or after it finishes execution. See the error_handler
-     * comments above and below. */
+    FreeVM(context);
+    if (context->savedPath)
+        UnallocateMem(context->savedPath);
+    UnallocateMem(context);
+}
 
-    if (value == -1) {
-        /* a fatal error occurred somewhere. */
-        FreeFontInfo(fontinfo);
+/* Parses and compiles the fontinfo, see fontinfo.c. On failure *fontinfo is
+ * left NULL. */
+static int
+PrepareFontInfo(const char* fontinfodata, ACFontInfo** fontinfo)
+{
+    *fontinfo = NULL;
+
+    /* LogMsg() returns control here whenever an error occurs during the rest
+     * of this function or of the ones below. Whatever was allocated so far is
+     * released, and only the current call fails; see logging.c. */
+    if (setjmp(gContext->mark) != 0) {
+        FreeFontInfo(*fontinfo);
+        *fontinfo = NULL;
         return AC_FatalError;
-    } else if (value == 1) {
-        /* AutoHint was called successfully */
-        FreeFontInfo(fontinfo);
+    }
 
-        if (gBezOutput->length >= *length)
-            *dstbezdata = ReallocateMem(*dstbezdata, gBezOutput->length + 1,
-                                        "Output buffer");
+    *fontinfo = ParseFontInfo(fontinfodata);
+    if (!*fontinfo)
+        return AC_MemoryError;
 
-        *length = gBezOutput->length + 1;
-        strncpy(*dstbezdata, gBezOutput->data, *length);
+    CompileFontInfo(*fontinfo);
 
-        FreeBuffer(gBezOutput);
+    return AC_Success;
+}
 
-        return AC_Success;
-    }
+/* Hints a glyph, writing it to the given buffer, which is owned by the
+ * caller, or storing it in hints when output is NULL. */
+static int
+HintGlyph(const ACFontInfo* fontinfo, const ACGlyphSource* glyph,
+          ACBuffer* output, ACHintResult* hints, int allowEdit,
+          int allowHintSub, int roundCoords)
+{
+    bool result;
 
-    gBezOutput = NewBuffer(*length);
-    if (!gBezOutput) {
-        FreeFontInfo(fontinfo);
-        return AC_MemoryError;
+    if (!glyph->bez && !glyph->path)
+        return AC_InvalidParameterError;
+
+    gBezOutput = output;
+    gHintResult = hints;
+
+    /* See PrepareFontInfo() above. */
+    if (setjmp(gContext->mark) != 0) {
+        gBezOutput = NULL;
+        gHintResult = NULL;
+        return AC_FatalError;
     }
 
     result = AutoHint(fontinfo,     /* font info */
-                      srcbezdata,   /* input glyph */
+                      glyph,        /* input glyph */
                       allowHintSub, /* extrahint */
                       allowEdit,    /* changeGlyphs */
                       roundCoords);
-    /* result == true is good */
 
-    /* The following call to error_handler() always returns control to just
-     * after the setjmp() function call above, but with value set to 1 if
-     * success, or -1 if not */
-    error_handler((result == true) ? OK : NONFATALERROR);
+    if (result && output)
+        FlushBuffer(output);
 
-    /* Shouldn't get here */
-    return AC_UnknownError;
+    gBezOutput = NULL;
+    gHintResult = NULL;
+
+    return result ? AC_Success : AC_FatalError;
 }
 
-ACLIB_API int
-AutoHintStringMM(const char** srcbezdata, const char* fontinfodata,
-                 int nmasters, const char** masters, char** dstbezdata,
-                 size_t* lengths)
+/* Hints a glyph directly into the caller's buffer, growing it if needed. The
+ * buffer is tracked in the context, as it may be reallocated before an error
+ * unwinds HintGlyph(). */
+static int
+HintGlyphToString(const ACFontInfo* fontinfo, const char* srcbezdata,
+                  char** dstbezdata, size_t* length, int allowEdit,
+                  int allowHintSub, int roundCoords)
+{
+    int result;
+    ACBuffer* output = &gContext->output;
+    ACGlyphSource glyph;
+
+    if (!dstbezdata || !length)
+        return AC_InvalidParameterError;
+
+    output->data = *dstbezdata;
+    output->capacity = *dstbezdata ? *length : 0;
+    output->length = 0;
+    output->writeCB = NULL;
+    output->userData = NULL;
+    if (output->capacity > 0)
+        output->data[0] = '\0';
+
+    glyph.bez = srcbezdata;
+    glyph.path = NULL;
+    result = HintGlyph(fontinfo, &glyph, output, NULL, allowEdit, allowHintSub,
+                       roundCoords);
+
+    *dstbezdata = output->data;
+    if (result == AC_Success)
+        *length = output->length + 1;
+    output->data = NULL;
+
+    return result;
+}
+
+static int
+HintString(const char* srcbezdata, const char* fontinfodata,
+           char** dstbezdata, size_t* length, int allowEdit, int allowHintSub,
+           int roundCoords)
+{
+    int result;
+    ACFontInfo* fontinfo;
+
+    if (!srcbezdata)
+        return AC_InvalidParameterError;
+
+    result = PrepareFontInfo(fontinfodata, &fontinfo);
+    if (result != AC_Success)
+        return result;
+
+    result = HintGlyphToString(fontinfo, srcbezdata, dstbezdata, length,
+                               allowEdit, allowHintSub, roundCoords);
+
+    FreeFontInfo(fontinfo);
+
+    return result;
+}
+
+static int
+HintStringBatch(const char* fontinfodata, const char** srcbezdata,
+                int nglyphs, char** dstbezdata, size_t* lengths, int* results,
+                int allowEdit, int allowHintSub, int roundCoords)
+{
+    int i, result, status;
+    ACFontInfo* fontinfo;
+
+    if (!srcbezdata || !dstbezdata || !lengths || nglyphs < 0)
+        return AC_InvalidParameterError;
+
+    status = PrepareFontInfo(fontinfodata, &fontinfo);
+
+    for (i = 0; i < nglyphs; i++) {
+        if (fontinfo != NULL) {
+            result = HintGlyphToString(fontinfo, srcbezdata[i],
+                                       &dstbezdata[i], &lengths[i], allowEdit,
+                                       allowHintSub, roundCoords);
+            if (status == AC_Success)
+                status = result;
+        } else {
+            result = status;
+        }
+        if (results)
+            results[i] = result;
+    }
+
+    FreeFontInfo(fontinfo);
+
+    return status;
+}
+
+static int
+HintStringMM(const char** srcbezdata, const char* fontinfodata, int nmasters,
+             const char** masters, char** dstbezdata, size_t* lengths)
 {
     /* Only the master with index 'hintsMasterIx' needs to be hinted; this is
      * why only the fontinfo data for that master is needed. This function
@@ -208,56 +302,456 @@ AutoHintStringMM(const char** srcbezdata, const char* fontinfodata,
      * charpath.c::MergeGlyphPaths(), then copies all the hintElts to the
      * current master main or path elements. (This actually happens in
      * charpath.c::InsertHint().) */
-    int value, result;
-    ACFontInfo* fontinfo = NULL;
+    bool result;
+    ACFontInfo* volatile fontinfo = NULL;
 
     if (!srcbezdata)
         return AC_InvalidParameterError;
 
+    /* See PrepareFontInfo() above. */
+    if (setjmp(gContext->mark) != 0) {
+        FreeFontInfo(fontinfo);
+        CleanupGlyphPaths();
+        return AC_FatalError;
+    }
+
+    /* Only the fontinfo entries are used here, the values compiled from them
+     * were already used when hinting the first master. */
     fontinfo = ParseFontInfo(fontinfodata);
     if (!fontinfo)
         return AC_MemoryError;
 
-    set_errorproc(error_handler);
-    value = setjmp(aclibmark);
+    /* The glyphs are read into the memory of the current context. */
+    InitAll(fontinfo, RESTART);
 
-    /* We will return here whenever an error occurs during the execution of
-     * AutoHint(), or after it finishes execution. See the error_handler
-     * comments above and below. */
+    result = MergeGlyphPaths(fontinfo, srcbezdata, nmasters, masters,
+                             dstbezdata, lengths);
 
-    if (value == -1) {
-        /* a fatal error occurred somewhere. */
-        FreeFontInfo(fontinfo);
-        return AC_FatalError;
-    } else if (value == 1) {
-        /* AutoHint was called successfully */
-        FreeFontInfo(fontinfo);
-        return AC_Success;
+    FreeFontInfo(fontinfo);
+
+    return result ? AC_Success : AC_FatalError;
+}
+
+ACLIB_API int
+AutoHintStringCtx(ACContext* context, const char* srcbezdata,
+                  const char* fontinfodata, char** dstbezdata, size_t* length,
+                  int allowEdit, int allowHintSub, int roundCoords)
+{
+    int result;
+
+    if (!context)
+        return AC_InvalidParameterError;
+
+    gContext = context;
+    result = HintString(srcbezdata, fontinfodata, dstbezdata, length,
+                        allowEdit, allowHintSub, roundCoords);
+    gContext = NULL;
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintString(const char* srcbezdata, const char* fontinfodata,
+               char** dstbezdata, size_t* length, int allowEdit,
+               int allowHintSub, int roundCoords)
+{
+    int result;
+    ACContext* context = AC_NewContext();
+
+    if (!context)
+        return AC_MemoryError;
+
+    result = AutoHintStringCtx(context, srcbezdata, fontinfodata, dstbezdata,
+                               length, allowEdit, allowHintSub, roundCoords);
+    AC_FreeContext(context);
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintStringMMCtx(ACContext* context, const char** srcbezdata,
+                    const char* fontinfodata, int nmasters,
+                    const char** masters, char** dstbezdata, size_t* lengths)
+{
+    int result;
+
+    if (!context)
+        return AC_InvalidParameterError;
+
+    gContext = context;
+    result = HintStringMM(srcbezdata, fontinfodata, nmasters, masters,
+                          dstbezdata, lengths);
+    gContext = NULL;
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintStringMM(const char** srcbezdata, const char* fontinfodata,
+                 int nmasters, const char** masters, char** dstbezdata,
+                 size_t* lengths)
+{
+    int result;
+    ACContext* context = AC_NewContext();
+
+    if (!context)
+        return AC_MemoryError;
+
+    result = AutoHintStringMMCtx(context, srcbezdata, fontinfodata, nmasters,
+                                 masters, dstbezdata, lengths);
+    AC_FreeContext(context);
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintStringBatch(const char* fontinfodata, const char** srcbezdata,
+                    int nglyphs, char** dstbezdata, size_t* lengths,
+                    int* results, int allowEdit, int allowHintSub,
+                    int roundCoords)
+{
+    int result;
+    ACContext* context = AC_NewContext();
+
+    if (!context)
+        return AC_MemoryError;
+
+    gContext = context;
+    result = HintStringBatch(fontinfodata, srcbezdata, nglyphs, dstbezdata,
+                             lengths, results, allowEdit, allowHintSub,
+                             roundCoords);
+    gContext = NULL;
+    AC_FreeContext(context);
+
+    return result;
+}
+
+ACLIB_API ACFontInfo*
+AC_CompileFontInfo(const char* fontinfodata)
+{
+    ACFontInfo* fontinfo;
+    ACContext* context;
+
+    if (!fontinfodata)
+        return NULL;
+
+    context = AC_NewContext();
+    if (!context)
+        return NULL;
+
+    gContext = context;
+    PrepareFontInfo(fontinfodata, &fontinfo);
+    gContext = NULL;
+    AC_FreeContext(context);
+
+    return fontinfo;
+}
+
+ACLIB_API void
+AC_FreeFontInfo(ACFontInfo* fontinfo)
+{
+    FreeFontInfo(fontinfo);
+}
+
+ACLIB_API int
+AutoHintStringFontInfo(ACContext* context, const ACFontInfo* fontinfo,
+                       const char* srcbezdata, char** dstbezdata,
+                       size_t* length, int allowEdit, int allowHintSub,
+                       int roundCoords)
+{
+    int result;
+
+    if (!context || !fontinfo)
+        return AC_InvalidParameterError;
+
+    gContext = context;
+    result = HintGlyphToString(fontinfo, srcbezdata, dstbezdata, length,
+                               allowEdit, allowHintSub, roundCoords);
+    gContext = NULL;
+
+    return result;
+}
+
+/* The size of the pieces passed to the callback of AutoHintStringWrite(). */
+#define WRITECHUNKSIZE 4096
+
+ACLIB_API int
+AutoHintStringWrite(ACContext* context, const ACFontInfo* fontinfo,
+                    const char* srcbezdata, AC_WRITEFUNCPTR writeCB,
+                    void* userData, int allowEdit, int allowHintSub,
+                    int roundCoords)
+{
+    int result;
+    char chunk[WRITECHUNKSIZE];
+    ACBuffer output;
+    ACGlyphSource glyph;
+
+    if (!context || !fontinfo || !writeCB)
+        return AC_InvalidParameterError;
+
+    output.data = chunk;
+    output.capacity = sizeof(chunk);
+    output.length = 0;
+    output.writeCB = writeCB;
+    output.userData = userData;
+
+    glyph.bez = srcbezdata;
+    glyph.path = NULL;
+
+    gContext = context;
+    result = HintGlyph(fontinfo, &glyph, &output, NULL, allowEdit,
+                       allowHintSub, roundCoords);
+    gContext = NULL;
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintCharstring(ACContext* context, const ACFontInfo* fontinfo,
+                   const char* srcbezdata, const double* width,
+                   unsigned char** charstring, size_t* length, int allowEdit,
+                   int allowHintSub, int roundCoords)
+{
+    int result;
+    ACCharstringOutput output;
+
+    if (!context || !fontinfo || !charstring || !length)
+        return AC_InvalidParameterError;
+
+    output.hasWidth = width != NULL;
+    output.width = width ? *width : 0;
+
+    gContext = context;
+    gCharstringOutput = &output;
+    result = HintGlyphToString(fontinfo, srcbezdata, (char**)charstring,
+                               length, allowEdit, allowHintSub, roundCoords);
+    gCharstringOutput = NULL;
+    gContext = NULL;
+
+    /* HintGlyphToString() counts the NUL it keeps after the data, which is
+     * not part of the charstring. */
+    if (result == AC_Success)
+        (*length)--;
+
+    return result;
+}
+
+ACLIB_API int
+AutoHintPath(ACContext* context, const ACFontInfo* fontinfo,
+             const ACPath* path, ACHintResult** result, int allowEdit,
+             int allowHintSub, int roundCoords)
+{
+    int status;
+    ACGlyphSource glyph;
+
+    if (!context || !fontinfo || !path || !result)
+        return AC_InvalidParameterError;
+
+    *result = NULL;
+    glyph.bez = NULL;
+    glyph.path = path;
+
+    *result = (ACHintResult*)AllocateMem(1, sizeof(ACHintResult), "hint result");
+    if (!*result)
+        return AC_MemoryError;
+
+    gContext = context;
+    status = HintGlyph(fontinfo, &glyph, NULL, *result, allowEdit,
+                       allowHintSub, roundCoords);
+    gContext = NULL;
+
+    if (status != AC_Success) {
+        FreeHintResult(*result);
+        *result = NULL;
     }
 
-    /* result == true is good */
-    result = MergeGlyphPaths(fontinfo, srcbezdata, nmasters, masters,
-                             dstbezdata, lengths);
+    return status;
+}
+
+ACLIB_API void
+AC_FreeHintResult(ACHintResult* result)
+{
+    FreeHintResult(result);
+}
+
+ACLIB_API int
+AC_DecodeCharstring(const char* name, const unsigned char* charstring,
+                    size_t length, const ACSubrs* localSubrs,
+                    const ACSubrs* globalSubrs, int allowDecimals,
+                    ACPath** path, double* width, int* hasWidth)
+{
+    int status;
+    bool gotWidth = false;
+
+    if (!charstring || !path || !width || !hasWidth)
+        return AC_InvalidParameterError;
+
+    status = DecodeCharstring(name, charstring, length, localSubrs,
+                              globalSubrs, allowDecimals, path, width,
+                              &gotWidth);
+    *hasWidth = gotWidth;
+
+    return status;
+}
 
-    /* The following call to error_handler() always returns control to just
-     * after the setjmp() function call above, but with value set to 1 if
-     * success, or -1 if not */
-    error_handler((result == true) ? OK : NONFATALERROR);
+ACLIB_API void
+AC_FreePath(ACPath* path)
+{
+    FreePath(path);
+}
+
+/* The glyphs of an AutoHintStringParallel() call. Each worker repeatedly
+ * takes the next glyph not yet taken, so the threads that get cheap glyphs
+ * simply hint more of them. */
+typedef struct
+{
+    const ACFontInfo* fontinfo;
+    const char** srcbezdata;
+    char** dstbezdata;
+    size_t* lengths;
+    int* results;
+    int nglyphs;
+    int next; /* next glyph to hint, guarded by mutex */
+    ACMutex* mutex;
+    int allowEdit, allowHintSub, roundCoords;
+} ParallelJob;
+
+typedef struct
+{
+    ParallelJob* job;
+    ACContext* context;
+    ACThread* thread;
+} ParallelWorker;
+
+static void
+ParallelWorkerMain(void* arg)
+{
+    ParallelWorker* worker = (ParallelWorker*)arg;
+    ParallelJob* job = worker->job;
+    int i;
+
+    gContext = worker->context;
+
+    for (;;) {
+        LockMutex(job->mutex);
+        i = job->next++;
+        UnlockMutex(job->mutex);
+
+        if (i >= job->nglyphs)
+            break;
+
+        job->results[i] =
+          HintGlyphToString(job->fontinfo, job->srcbezdata[i],
+                            &job->dstbezdata[i], &job->lengths[i],
+                            job->allowEdit, job->allowHintSub,
+                            job->roundCoords);
+    }
+
+    gContext = NULL;
+}
+
+ACLIB_API int
+AutoHintStringParallel(const char* fontinfodata, const char** srcbezdata,
+                       int nglyphs, char** dstbezdata, size_t* lengths,
+                       int* results, int allowEdit, int allowHintSub,
+                       int roundCoords, int nthreads)
+{
+    int i, result;
+    ParallelJob job;
+    ParallelWorker* workers = NULL;
+    ACFontInfo* fontinfo = NULL;
+
+    if (!srcbezdata || !dstbezdata || !lengths || nglyphs < 0)
+        return AC_InvalidParameterError;
+
+    if (nthreads > nglyphs)
+        nthreads = nglyphs;
+    if (nthreads <= 1)
+        return AutoHintStringBatch(fontinfodata, srcbezdata, nglyphs,
+                                   dstbezdata, lengths, results, allowEdit,
+                                   allowHintSub, roundCoords);
+
+    memset(&job, 0, sizeof(job));
+    result = AC_MemoryError;
+
+    fontinfo = AC_CompileFontInfo(fontinfodata);
+    if (!fontinfo) {
+        result = AC_FatalError;
+        goto cleanup;
+    }
+
+    job.results = results;
+    if (!job.results) {
+        job.results = (int*)AllocateMem(nglyphs, sizeof(int), "results");
+        if (!job.results)
+            goto cleanup;
+    }
+
+    job.mutex = NewMutex();
+    workers = (ParallelWorker*)AllocateMem(nthreads, sizeof(ParallelWorker),
+                                           "workers");
+    if (!job.mutex || !workers)
+        goto cleanup;
+
+    for (i = 0; i < nthreads; i++) {
+        workers[i].job = &job;
+        workers[i].context = AC_NewContext();
+        if (!workers[i].context)
+            goto cleanup;
+    }
+
+    job.fontinfo = fontinfo;
+    job.srcbezdata = srcbezdata;
+    job.dstbezdata = dstbezdata;
+    job.lengths = lengths;
+    job.nglyphs = nglyphs;
+    job.allowEdit = allowEdit;
+    job.allowHintSub = allowHintSub;
+    job.roundCoords = roundCoords;
+
+    /* The calling thread is the first worker. If some threads can't be
+     * started, the others pick up their share of the glyphs. */
+    for (i = 1; i < nthreads; i++)
+        workers[i].thread = StartThread(ParallelWorkerMain, &workers[i]);
+    ParallelWorkerMain(&workers[0]);
+    for (i = 1; i < nthreads; i++)
+        JoinThread(workers[i].thread);
+
+    /* Same as AutoHintStringBatch(), report the first glyph that failed. */
+    result = AC_Success;
+    for (i = 0; i < nglyphs && result == AC_Success; i++)
+        result = job.results[i];
+
+cleanup:
+    /* job.fontinfo is only set once the glyphs are about to be hinted; on
+     * an earlier failure none of them was, so report it for each glyph. */
+    if (!job.fontinfo && results)
+        for (i = 0; i < nglyphs; i++)
+            results[i] = result;
+    if (workers) {
+        for (i = 0; i < nthreads; i++)
+            AC_FreeContext(workers[i].context);
+        UnallocateMem(workers);
+    }
+    FreeMutex(job.mutex);
+    if (job.results != results)
+        UnallocateMem(job.results);
+    AC_FreeFontInfo(fontinfo);
 
-    /* Shouldn't get here */
-    return AC_UnknownError;
+    return result;
 }
 
 ACLIB_API void
 AC_initCallGlobals(void)
 {
-    gLibReportCB = NULL;
-    gAddGlyphExtremesCB = NULL;
-    gAddStemExtremesCB = NULL;
-    gDoAligns = false;
-    gAddHStemCB = NULL;
-    gAddVStemCB = NULL;
-    gDoStems = false;
+    defaultContext.reportCB = NULL;
+    defaultReportLevel = LOGDEBUG;
+    defaultContext.addGlyphExtremesCB = NULL;
+    defaultContext.addStemExtremesCB = NULL;
+    defaultContext.doAligns = false;
+    defaultContext.addHStemCB = NULL;
+    defaultContext.addVStemCB = NULL;
+    defaultContext.doStems = false;
 }
 
 ACLIB_API const char*
@@ -14,15 +14,17 @@
 #include "fontinfo.h"
 #include "opcodes.h"
 
-char gGlyphName[MAX_GLYPHNAME_LEN];
+AC_THREAD_LOCAL char gGlyphName[MAX_GLYPHNAME_LEN];
 
-static Fixed currentx, currenty; /* used to calculate absolute coordinates */
-static Fixed tempx, tempy;       /* used to calculate relative coordinates */
+/* used to calculate absolute coordinates */
+static AC_THREAD_LOCAL Fixed currentx, currenty;
+/* used to calculate relative coordinates */
+static AC_THREAD_LOCAL Fixed tempx, tempy;
 #define STKMAX (20)
-static Fixed stk[STKMAX];
-static int32_t stkindex;
-static bool flex, startchar;
-static bool forMultiMaster, includeHints;
+static AC_THREAD_LOCAL Fixed stk[STKMAX];
+static AC_THREAD_LOCAL int32_t stkindex;
+static AC_THREAD_LOCAL bool flex, startchar;
+static AC_THREAD_LOCAL bool forMultiMaster, includeHints;
 /* Reading file for comparison of multiple master data and hint information.
    Reads into GlyphPathElt structure instead of PathElt. */
 
@@ -521,3 +523,59 @@ ReadGlyph(const ACFontInfo* fontinfo, const char* srcglyph, bool forBlendData,
 
     return true;
 }
+
+/* Reads a glyph given as arrays, see ACPath in psautohint.h. */
+bool
+ReadGlyphPath(const ACPath* path)
+{
+    const int* c;
+    PathElt* e;
+    int i;
+
+    if (!path || path->nops < 0 ||
+        (path->nops > 0 && (!path->ops || !path->coords)))
+        return false;
+
+    gPathStart = gPathEnd = NULL;
+    gGlyphName[0] = '\0';
+    if (path->name) {
+        if (strlen(path->name) >= MAX_GLYPHNAME_LEN) {
+            LogMsg(LOGERROR, NONFATALERROR,
+                   "Bad input data. Glyph name is greater than %d chars.",
+                   MAX_GLYPHNAME_LEN);
+        }
+        strcpy(gGlyphName, path->name);
+    }
+
+    c = path->coords;
+    for (i = 0; i < path->nops; i++) {
+        switch (path->ops[i]) {
+            case AC_MOVETO:
+            case AC_LINETO:
+                e = AppendElement(path->ops[i] == AC_MOVETO ? MOVETO : LINETO);
+                e->x = c[0];
+                e->y = -c[1];
+                c += 2;
+                break;
+            case AC_CURVETO:
+                e = AppendElement(CURVETO);
+                e->x1 = c[0];
+                e->y1 = -c[1];
+                e->x2 = c[2];
+                e->y2 = -c[3];
+                e->x3 = c[4];
+                e->y3 = -c[5];
+                c += 6;
+                break;
+            case AC_CLOSEPATH:
+                AppendElement(CLOSEPATH);
+                break;
+            default:
+                LogMsg(LOGERROR, NONFATALERROR,
+                       "Bad input data. Unknown path operator: %d.",
+                       path->ops[i]);
+        }
+    }
+
+    return true;
+}
@@ -208,6 +208,8 @@ ShowHVal(HintVal* val)
 {
     Fixed l, r;
     HintSeg* seg;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     ShwHV(val);
     seg = val->vSeg1;
     if (seg == NULL)
@@ -224,6 +226,8 @@ ShowHVal(HintVal* val)
 void
 ShowHVals(HintVal* lst)
 {
+    if (!LogEnabled(LOGDEBUG))
+        return;
     while (lst != NULL) {
         ShowHVal(lst);
         lst = lst->vNxt;
@@ -252,6 +256,8 @@ ShowVVal(HintVal* val)
 {
     Fixed b, t;
     HintSeg* seg;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     ShwVV(val);
     seg = val->vSeg1;
     if (seg == NULL)
@@ -268,6 +274,8 @@ ShowVVal(HintVal* val)
 void
 ShowVVals(HintVal* lst)
 {
+    if (!LogEnabled(LOGDEBUG))
+        return;
     while (lst != NULL) {
         ShowVVal(lst);
         lst = lst->vNxt;
@@ -358,6 +366,8 @@ ListHintInfo(void)
     SegLnkLst *hLst, *vLst;
     HintSeg* seg;
     Fixed x, y;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     e = gPathStart;
     while (e != NULL) {
         hLst = e->Hs;
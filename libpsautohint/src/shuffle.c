@@ -10,8 +10,8 @@
 #include "ac.h"
 #define MAXCNT (100)
 
-static unsigned char* links;
-static int32_t rowcnt;
+static AC_THREAD_LOCAL unsigned char* links;
+static AC_THREAD_LOCAL int32_t rowcnt;
 
 void
 InitShuffleSubpaths(void)
@@ -38,6 +38,8 @@ static void
 PrintLinks(void)
 {
     int32_t i, j;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     LogMsg(LOGDEBUG, OK, "Links ");
     for (i = 0; i < rowcnt; i++) {
         LogMsg(LOGDEBUG, OK, "%d  ", i);
@@ -60,6 +62,8 @@ static void
 PrintSumLinks(char* sumlinks)
 {
     int32_t i;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     LogMsg(LOGDEBUG, OK, "Sumlinks ");
     for (i = 0; i < rowcnt; i++) {
         LogMsg(LOGDEBUG, OK, "%d  ", i);
@@ -78,6 +82,8 @@ static void
 PrintOutLinks(unsigned char* outlinks)
 {
     int32_t i;
+    if (!LogEnabled(LOGDEBUG))
+        return;
     LogMsg(LOGDEBUG, OK, "Outlinks ");
     for (i = 0; i < rowcnt; i++) {
         LogMsg(LOGDEBUG, OK, "%d  ", i);
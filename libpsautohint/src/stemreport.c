@@ -12,37 +12,37 @@
 void
 AddVStem(Fixed top, Fixed bottom, bool curved)
 {
-    if (curved && !gAllStems)
+    if (curved && !gContext->allStems)
         return;
 
-    if (gAddVStemCB != NULL) {
-        gAddVStemCB(top, bottom, gGlyphName);
+    if (gContext->addVStemCB != NULL) {
+        gContext->addVStemCB(top, bottom, gGlyphName);
     }
 }
 
 void
 AddHStem(Fixed right, Fixed left, bool curved)
 {
-    if (curved && !gAllStems)
+    if (curved && !gContext->allStems)
         return;
 
-    if (gAddHStemCB != NULL) {
-        gAddHStemCB(right, left, gGlyphName);
+    if (gContext->addHStemCB != NULL) {
+        gContext->addHStemCB(right, left, gGlyphName);
     }
 }
 
 void
 AddGlyphExtremes(Fixed bot, Fixed top)
 {
-    if (gAddGlyphExtremesCB != NULL) {
-        gAddGlyphExtremesCB(top, bot, gGlyphName);
+    if (gContext->addGlyphExtremesCB != NULL) {
+        gContext->addGlyphExtremesCB(top, bot, gGlyphName);
     }
 }
 
 void
 AddStemExtremes(Fixed bot, Fixed top)
 {
-    if (gAddStemExtremesCB != NULL) {
-        gAddStemExtremesCB(top, bot, gGlyphName);
+    if (gContext->addStemExtremesCB != NULL) {
+        gContext->addStemExtremesCB(top, bot, gGlyphName);
     }
 }
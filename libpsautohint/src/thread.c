@@ -0,0 +1,157 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "memory.h"
+#include "thread.h"
+
+struct _acthread
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ACThreadFunc func;
+    void* arg;
+};
+
+struct _acmutex
+{
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+#ifdef _WIN32
+static DWORD WINAPI
+ThreadMain(LPVOID arg)
+{
+    ACThread* thread = (ACThread*)arg;
+
+    thread->func(thread->arg);
+    return 0;
+}
+#else
+static void*
+ThreadMain(void* arg)
+{
+    ACThread* thread = (ACThread*)arg;
+
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif
+
+ACThread*
+StartThread(ACThreadFunc func, void* arg)
+{
+    ACThread* thread;
+
+    thread = (ACThread*)AllocateMem(1, sizeof(ACThread), "thread");
+    if (!thread)
+        return NULL;
+
+    thread->func = func;
+    thread->arg = arg;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, ThreadMain, thread, 0, NULL);
+    if (thread->handle == NULL) {
+        UnallocateMem(thread);
+        return NULL;
+    }
+#else
+    if (pthread_create(&thread->handle, NULL, ThreadMain, thread) != 0) {
+        UnallocateMem(thread);
+        return NULL;
+    }
+#endif
+
+    return thread;
+}
+
+void
+JoinThread(ACThread* thread)
+{
+    if (!thread)
+        return;
+
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+
+    UnallocateMem(thread);
+}
+
+ACMutex*
+NewMutex(void)
+{
+    ACMutex* mutex;
+
+    mutex = (ACMutex*)AllocateMem(1, sizeof(ACMutex), "mutex");
+    if (!mutex)
+        return NULL;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&mutex->lock);
+#else
+    if (pthread_mutex_init(&mutex->lock, NULL) != 0) {
+        UnallocateMem(mutex);
+        return NULL;
+    }
+#endif
+
+    return mutex;
+}
+
+void
+LockMutex(ACMutex* mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_lock(&mutex->lock);
+#endif
+}
+
+void
+UnlockMutex(ACMutex* mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_unlock(&mutex->lock);
+#endif
+}
+
+void
+FreeMutex(ACMutex* mutex)
+{
+    if (!mutex)
+        return;
+
+#ifdef _WIN32
+    DeleteCriticalSection(&mutex->lock);
+#else
+    pthread_mutex_destroy(&mutex->lock);
+#endif
+
+    UnallocateMem(mutex);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* A minimal portable wrapper around the native threads, used to hint glyphs
+ * in parallel, see AutoHintStringParallel(). */
+
+#ifndef AC_THREAD_H_
+#define AC_THREAD_H_
+
+#include "basic.h"
+
+typedef struct _acthread ACThread;
+typedef struct _acmutex ACMutex;
+
+typedef void (*ACThreadFunc)(void* arg);
+
+/* Starts running func(arg) in a new thread. Returns NULL if the thread could
+ * not be created. */
+ACThread* StartThread(ACThreadFunc func, void* arg);
+/* Waits for the thread to finish and releases it. */
+void JoinThread(ACThread* thread);
+
+ACMutex* NewMutex(void);
+void LockMutex(ACMutex* mutex);
+void UnlockMutex(ACMutex* mutex);
+void FreeMutex(ACMutex* mutex);
+
+#endif /* AC_THREAD_H_ */
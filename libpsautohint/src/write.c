@@ -13,13 +13,13 @@
 
 #define WRTABS_COMMENT (0)
 
-static Fixed currentx, currenty;
-static bool firstFlex, wrtHintInfo;
-static char S0[MAXBUFFLEN + 1];
-static HintPoint* bst;
-static char bch;
-static Fixed bx, by;
-static bool bstB;
+static AC_THREAD_LOCAL Fixed currentx, currenty;
+static AC_THREAD_LOCAL bool firstFlex, wrtHintInfo;
+static AC_THREAD_LOCAL char S0[MAXBUFFLEN + 1];
+static AC_THREAD_LOCAL HintPoint* bst;
+static AC_THREAD_LOCAL char bch;
+static AC_THREAD_LOCAL Fixed bx, by;
+static AC_THREAD_LOCAL bool bstB;
 
 int32_t
 FRnd(int32_t x)
@@ -38,37 +38,13 @@ FRnd(int32_t x)
 static void
 WriteString(char* str)
 {
-    if (!gBezOutput) {
-        LogMsg(LOGERROR, FATALERROR, "NULL output buffer while writing glyph.");
-        return;
-    }
-
-    if ((gBezOutput->length + strlen(str)) >= gBezOutput->capacity) {
-        size_t desiredsize =
-          NUMMAX(gBezOutput->capacity * 2, gBezOutput->capacity + strlen(str));
-        gBezOutput->data =
-          ReallocateMem(gBezOutput->data, desiredsize, "output bez data");
-        if (gBezOutput->data)
-            gBezOutput->capacity = desiredsize;
-        else
-            return; /*FATAL ERROR*/
-    }
-    strcat(gBezOutput->data, str);
-    gBezOutput->length += strlen(str);
+    BufferWriteString(gBezOutput, str);
 }
 
 /* Note: The 8 bit fixed fraction cannot support more than 2 decimal places. */
-#define WRTNUM(i)                                                              \
-    {                                                                          \
-        snprintf(S0, MAXBUFFLEN, "%d ", (int32_t)(i));                         \
-        WriteString(S0);                                                       \
-    }
+#define WRTNUM(i) BufferWriteInt(gBezOutput, (int32_t)(i))
 
-#define WRTRNUM(i)                                                             \
-    {                                                                          \
-        snprintf(S0, MAXBUFFLEN, "%0.2f ", roundf((float)(i)*100) / 100);      \
-        WriteString(S0);                                                       \
-    }
+#define WRTRNUM(i) BufferWriteFloat2(gBezOutput, (float)(i))
 
 static void
 wrtxa(Fixed x)
@@ -106,8 +82,8 @@ wrtya(Fixed y)
 
 /*To avoid pointless hint subs*/
 #define HINTMAXSTR 2048
-static char hintmaskstr[HINTMAXSTR];
-static char prevhintmaskstr[HINTMAXSTR];
+static AC_THREAD_LOCAL char hintmaskstr[HINTMAXSTR];
+static AC_THREAD_LOCAL char prevhintmaskstr[HINTMAXSTR];
 
 static void
 safestrcat(char* s1, char* s2)
@@ -123,13 +99,13 @@ safestrcat(char* s1, char* s2)
 
 #define SWRTNUM(i)                                                             \
     {                                                                          \
-        snprintf(S0, MAXBUFFLEN, "%d ", (int32_t)(i));                         \
+        FormatInt(S0, (int32_t)(i));                                           \
         sws(S0);                                                               \
     }
 
 #define SWRTNUMA(i)                                                            \
     {                                                                          \
-        snprintf(S0, MAXBUFFLEN, "%0.2f ", roundf((float)(i)*100) / 100);      \
+        FormatFloat2(S0, (float)(i));                                          \
         sws(S0);                                                               \
     }
 
@@ -190,57 +166,73 @@ WritePointItem(const ACFontInfo* fontinfo, HintPoint* lst)
     sws("\n");
 }
 
-static void
-WrtPntLst(const ACFontInfo* fontinfo, HintPoint* lst)
+/* Marks all the points of the list as not yet written. */
+void
+ResetPntLst(HintPoint* lst)
 {
-    HintPoint* ptLst;
+    while (lst != NULL) {
+        lst->done = false;
+        lst = lst->next;
+    }
+}
+
+/* Returns the next point of the list to write in sort order, and marks it as
+ * written, or NULL when all of them have been. */
+HintPoint*
+NextPntLst(HintPoint* ptLst)
+{
+    HintPoint* lst;
     char ch;
     Fixed x0, x1, y0, y1;
-    ptLst = lst;
 
-    while (lst != NULL) { /* mark all as not yet done */
-        lst->done = false;
+    lst = ptLst;
+    bst = NULL;
+    while (lst != NULL) { /* find first not yet done as init best */
+        if (!lst->done) {
+            NewBest(lst);
+            break;
+        }
         lst = lst->next;
     }
-    while (true) { /* write in sort order */
-        lst = ptLst;
-        bst = NULL;
-        while (lst != NULL) { /* find first not yet done as init best */
-            if (!lst->done) {
+    if (bst == NULL) {
+        return NULL; /* finished with entire list */
+    }
+    lst = bst->next;
+    while (lst != NULL) { /* search for best */
+        if (!lst->done) {
+            ch = lst->c;
+            if (ch > bch) {
                 NewBest(lst);
-                break;
-            }
-            lst = lst->next;
-        }
-        if (bst == NULL) {
-            break; /* finished with entire list */
-        }
-        lst = bst->next;
-        while (lst != NULL) { /* search for best */
-            if (!lst->done) {
-                ch = lst->c;
-                if (ch > bch) {
-                    NewBest(lst);
-                } else if (ch == bch) {
-                    if (bstB) {
-                        x0 = lst->x0;
-                        x1 = lst->x1;
-                        if (NUMMIN(x0, x1) < bx) {
-                            NewBest(lst);
-                        }
-                    } else {
-                        y0 = lst->y0;
-                        y1 = lst->y1;
-                        if (NUMMIN(y0, y1) < by) {
-                            NewBest(lst);
-                        }
+            } else if (ch == bch) {
+                if (bstB) {
+                    x0 = lst->x0;
+                    x1 = lst->x1;
+                    if (NUMMIN(x0, x1) < bx) {
+                        NewBest(lst);
+                    }
+                } else {
+                    y0 = lst->y0;
+                    y1 = lst->y1;
+                    if (NUMMIN(y0, y1) < by) {
+                        NewBest(lst);
                     }
                 }
             }
-            lst = lst->next;
         }
-        bst->done = true; /* mark as having been done */
-        WritePointItem(fontinfo, bst);
+        lst = lst->next;
+    }
+    bst->done = true; /* mark as having been done */
+    return bst;
+}
+
+static void
+WrtPntLst(const ACFontInfo* fontinfo, HintPoint* lst)
+{
+    HintPoint* pt;
+
+    ResetPntLst(lst);
+    while ((pt = NextPntLst(lst)) != NULL) { /* write in sort order */
+        WritePointItem(fontinfo, pt);
     }
 }
 
@@ -294,8 +286,8 @@ dt(const ACFontInfo* fontinfo, Cd c, PathElt* e)
     WriteString("dt\n");
 }
 
-static Fixed flX, flY;
-static Cd fc1, fc2, fc3;
+static AC_THREAD_LOCAL Fixed flX, flY;
+static AC_THREAD_LOCAL Cd fc1, fc2, fc3;
 
 #define wrtpreflx2a(c)                                                         \
     wrtcda(c);                                                                 \
@@ -417,12 +409,186 @@ NumberPath(void)
     }
 }
 
+static void
+SetResultStem(ACStem* stem, HintPoint* pt)
+{
+    stem->type = pt->c;
+    switch (pt->c) {
+        case 'b':
+        case 'v':
+            stem->pos = pt->y0;
+            stem->width = pt->y1 - pt->y0;
+            break;
+        case 'y':
+        case 'm':
+            stem->pos = pt->x0;
+            stem->width = pt->x1 - pt->x0;
+            break;
+        default: {
+            LogMsg(LOGERROR, NONFATALERROR, "Illegal point list data.");
+        }
+    }
+    stem->elt0 = pt->p0 != NULL ? pt->p0->count - 1 : -1;
+    stem->elt1 = pt->p1 != NULL ? pt->p1->count - 1 : -1;
+}
+
+static bool
+SameResultStems(const ACStem* s1, const ACStem* s2, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (s1[i].type != s2[i].type || s1[i].pos != s2[i].pos ||
+            s1[i].width != s2[i].width || s1[i].elt0 != s2[i].elt0 ||
+            s1[i].elt1 != s2[i].elt1)
+            return false;
+    }
+    return true;
+}
+
+/* Adds the hint set starting at path element op, unless it is the same as the
+ * one before it; SaveFile() skips those as well. */
+static void
+AddResultHintSet(ACHintResult* result, HintPoint* lst, int op)
+{
+    ACHintSet* set = &result->hintsets[result->nhintsets];
+    HintPoint* pt;
+    int count = 0, prevFirst = 0, prevCount = 0;
+
+    ResetPntLst(lst);
+    while ((pt = NextPntLst(lst)) != NULL)
+        SetResultStem(&result->stems[result->nstems + count++], pt);
+
+    if (result->nhintsets > 0) {
+        prevFirst = set[-1].first;
+        prevCount = set[-1].count;
+    }
+    if (count == prevCount &&
+        SameResultStems(&result->stems[prevFirst],
+                        &result->stems[result->nstems], count))
+        return;
+
+    set->op = op;
+    set->first = result->nstems;
+    set->count = count;
+    result->nstems += count;
+    result->nhintsets++;
+}
+
+int
+CountPntLst(HintPoint* lst)
+{
+    int count = 0;
+
+    for (; lst != NULL; lst = lst->next)
+        count++;
+    return count;
+}
+
+/* Stores the glyph in gHintResult, see AutoHintPath(). */
+static void
+SaveHintResult(void)
+{
+    ACHintResult* result = gHintResult;
+    PathElt* e;
+    int nops = 0, ncoords = 0, nstems = 0, nsets = 0, i;
+    int* c;
+    bool flexStart = true;
+
+    wrtHintInfo = (gPathStart != NULL && gPathStart != gPathEnd);
+    NumberPath();
+
+    for (e = gPathStart; e != NULL; e = e->next) {
+        nops++;
+        ncoords += e->type == CURVETO ? 6 : e->type == CLOSEPATH ? 0 : 2;
+        if (wrtHintInfo && (e == gPathStart || e->newhints != 0)) {
+            nstems += CountPntLst(gPtLstArray[e->newhints]);
+            nsets++;
+        }
+    }
+
+    /* The sizes are at least 1, as AllocateMem() fails for 0 bytes. */
+    result->ops = AllocateMem(NUMMAX(nops, 1), 1, "hint result");
+    result->flex = AllocateMem(NUMMAX(nops, 1), 1, "hint result");
+    result->coords = AllocateMem(NUMMAX(ncoords, 1), sizeof(int), "hint result");
+    result->stems = AllocateMem(NUMMAX(nstems, 1), sizeof(ACStem), "hint result");
+    result->hintsets =
+      AllocateMem(NUMMAX(nsets, 1), sizeof(ACHintSet), "hint result");
+    if (!result->ops || !result->flex || !result->coords || !result->stems ||
+        !result->hintsets)
+        return;
+
+    c = result->coords;
+    for (e = gPathStart, i = 0; e != NULL; e = e->next, i++) {
+        if (wrtHintInfo && (e == gPathStart || e->newhints != 0))
+            AddResultHintSet(result, gPtLstArray[e->newhints], i);
+        switch (e->type) {
+            case CURVETO:
+                result->ops[i] = AC_CURVETO;
+                *c++ = FRnd(e->x1);
+                *c++ = FRnd(-e->y1);
+                *c++ = FRnd(e->x2);
+                *c++ = FRnd(-e->y2);
+                *c++ = FRnd(e->x3);
+                *c++ = FRnd(-e->y3);
+                /* Same pairing of the flex halves as in ct(). */
+                if (e->isFlex) {
+                    if (flexStart && e->next != NULL && e->next->isFlex) {
+                        result->flex[i] = 1;
+                        flexStart = false;
+                    } else if (!flexStart && e->prev != NULL &&
+                               e->prev->isFlex) {
+                        result->flex[i] = 1;
+                        flexStart = true;
+                    }
+                }
+                break;
+            case LINETO:
+            case MOVETO:
+                result->ops[i] = e->type == MOVETO ? AC_MOVETO : AC_LINETO;
+                *c++ = FRnd(e->x);
+                *c++ = FRnd(-e->y);
+                break;
+            case CLOSEPATH:
+                result->ops[i] = AC_CLOSEPATH;
+                break;
+            default: {
+                LogMsg(LOGERROR, NONFATALERROR, "Illegal path list.");
+            }
+        }
+    }
+    result->nops = nops;
+}
+
+void
+FreeHintResult(ACHintResult* result)
+{
+    if (!result)
+        return;
+
+    UnallocateMem(result->ops);
+    UnallocateMem(result->flex);
+    UnallocateMem(result->coords);
+    UnallocateMem(result->stems);
+    UnallocateMem(result->hintsets);
+    UnallocateMem(result);
+}
+
 void
 SaveFile(const ACFontInfo* fontinfo)
 {
     PathElt* e = gPathStart;
     Cd c1, c2, c3;
 
+    if (gHintResult != NULL) {
+        SaveHintResult();
+        return;
+    }
+    if (gCharstringOutput != NULL) {
+        SaveCharstring();
+        return;
+    }
+
     WriteString("% ");
     WriteString(gGlyphName);
     WriteString("\n");
@@ -469,7 +635,7 @@ SaveFile(const ACFontInfo* fontinfo)
         }
 #if WRTABS_COMMENT
         WriteString(" % ");
-        WRTNUM(e->count)
+        WRTNUM(e->count);
         switch (e->type) {
             case CURVETO:
                 wrtfx(c1.x);
@@ -63,6 +63,35 @@ def hint_bez_glyph(info, glyph, allow_edit=True, allow_hint_sub=True,
     return tounicode(hinted)
 
 
+def hint_glyph_charstring(info, glyph, width, allow_edit=True,
+                          allow_hint_sub=True, round_coordinates=True):
+    return _psautohint.autohint_charstring(tobytes(info),
+                                           tobytes(glyph),
+                                           width,
+                                           allow_edit,
+                                           allow_hint_sub,
+                                           round_coordinates)
+
+
+def hint_glyphs(info, glyphs, widths=None, allow_edit=True,
+                allow_hint_sub=True, round_coordinates=True):
+    # The glyphs are hinted as bez, or as charstrings when widths are given.
+    # Returns a (glyph, records) pair per glyph: a glyph that fails is
+    # returned as the exception it raised, and records are the (level,
+    # message) pairs the library reported for it, left to the caller to log.
+    hinted = _psautohint.autohint_batch(tobytes(info),
+                                        [tobytes(g) for g in glyphs],
+                                        widths,
+                                        allow_edit,
+                                        allow_hint_sub,
+                                        round_coordinates)
+    if widths is not None:
+        return hinted
+
+    return [(g if isinstance(g, Exception) else tounicode(g), records)
+            for g, records in hinted]
+
+
 def hint_compatible_bez_glyphs(info, glyphs, masters):
     hinted = _psautohint.autohintmm(tobytes(info),
                                     tuple(tobytes(g) for g in glyphs),
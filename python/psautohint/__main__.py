@@ -336,6 +336,8 @@ class Options(ACOptions):
         self.printFDDictList = pargs.print_list_fddict
         self.allowDecimalCoords = pargs.decimal
         self.writeToDefaultLayer = pargs.write_to_default_layer
+        self.jobs = pargs.jobs
+        self.hintCache = pargs.cache
 
 
 class _CustomHelpFormatter(argparse.RawDescriptionHelpFormatter):
@@ -413,6 +415,17 @@ def _validate_font_paths(path_lst, parser):
     return ft_format_str
 
 
+def _check_jobs(jobs_str):
+    try:
+        jobs = int(jobs_str)
+    except ValueError:
+        jobs = 0
+    if jobs < 1:
+        raise argparse.ArgumentTypeError(
+            "{} is not a valid number of jobs.".format(jobs_str))
+    return jobs
+
+
 def _validate_path(path_str):
     valid_path = os.path.abspath(os.path.realpath(path_str))
     if not os.path.exists(valid_path):
@@ -584,6 +597,25 @@ def get_options(args):
         action='store_true',
         help='allow the font to have no alignment zones nor stem widths'
     )
+    parser.add_argument(
+        '-j',
+        '--jobs',
+        metavar='N',
+        type=_check_jobs,
+        default=1,
+        help='hint the glyphs using N worker processes\n'
+             'The output is the same regardless of the number of processes.'
+    )
+    parser.add_argument(
+        '--cache',
+        metavar='DIR',
+        type=os.path.abspath,
+        help='keep the hinted glyphs in DIR, and reuse them when hinting '
+             'the same glyphs with the same settings again\n'
+             'The directory is created if needed, and can be shared by '
+             'several fonts and runs. The messages logged while hinting a '
+             'glyph are stored with it and logged again when it is reused.'
+    )
     parser.add_argument(
         '--fontinfo-file',
         metavar='PATH',
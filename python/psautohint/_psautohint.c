@@ -32,47 +32,225 @@ typedef unsigned char bool;
 
 #include "psautohint.h"
 
+/* The library allocates memory while the GIL is released, so only the raw
+ * allocators can be used. */
+#if PY_MAJOR_VERSION >= 3
+#define MEMNEW(size) PyMem_RawCalloc(1, size)
+#define MEMFREE(ptr) PyMem_RawFree(ptr)
+#define MEMRENEW(ptr, size) PyMem_RawRealloc(ptr, size)
+#else
+#define MEMNEW(size) calloc(1, size)
+#define MEMFREE(ptr) free(ptr)
+#define MEMRENEW(ptr, size) realloc(ptr, size)
+#endif
+
+/* Storage class of the log buffer of the current thread, see reportCB(). */
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/* The hinting runs without holding the GIL, so the library messages can't be
+ * passed to Python as they are reported. They are collected in a LogBuffer
+ * and passed to the logging module once the GIL is held again. */
+typedef struct
+{
+    int level;
+    char* msg;
+} LogRecord;
+
+typedef struct
+{
+    LogRecord* records;
+    size_t length;
+    size_t capacity;
+    int level;
+} LogBuffer;
+
+static THREAD_LOCAL LogBuffer* currentLog = NULL;
+
 static void
 reportCB(char* msg, int level)
+{
+    LogBuffer* buffer = currentLog;
+    LogRecord* records;
+    char* copy;
+    size_t len;
+
+    if (buffer == NULL)
+        return;
+
+    if (buffer->length == buffer->capacity) {
+        size_t capacity = buffer->capacity ? 2 * buffer->capacity : 16;
+        records = MEMRENEW(buffer->records, capacity * sizeof(LogRecord));
+        if (records == NULL)
+            return;
+        buffer->records = records;
+        buffer->capacity = capacity;
+    }
+
+    len = strlen(msg);
+    copy = MEMNEW(len + 1);
+    if (copy == NULL)
+        return;
+    memcpy(copy, msg, len + 1);
+
+    buffer->records[buffer->length].level = level;
+    buffer->records[buffer->length].msg = copy;
+    buffer->length++;
+}
+
+/* Returns a borrowed reference to the "_psautohint" logger, or NULL. Must be
+ * called with the GIL held. */
+static PyObject*
+getLogger(void)
 {
     static PyObject* logger = NULL;
 
     if (logger == NULL) {
         PyObject* logging = PyImport_ImportModule("logging");
-        if (logging == NULL)
-            return;
-        logger = PyObject_CallMethod(logging, "getLogger", "s", "_psautohint");
+        if (logging != NULL) {
+            logger =
+              PyObject_CallMethod(logging, "getLogger", "s", "_psautohint");
+            Py_DECREF(logging);
+        }
         if (logger == NULL)
-            return;
+            PyErr_Clear();
+    }
+
+    return logger;
+}
+
+/* Starts collecting the messages of the current thread into buffer. The
+ * report level of the messages the logger would not drop is kept in buffer,
+ * to be set on the contexts hinting for it so that the others are not even
+ * formatted. Must be called with the GIL held. */
+static void
+beginLog(LogBuffer* buffer)
+{
+    PyObject* logger = getLogger();
+    int level = AC_LogDebug;
+
+    if (logger != NULL) {
+        PyObject* levelObj =
+          PyObject_CallMethod(logger, "getEffectiveLevel", NULL);
+        long value = levelObj ? PyLong_AsLong(levelObj) : -1;
+        Py_XDECREF(levelObj);
+        if (value == -1 && PyErr_Occurred())
+            PyErr_Clear();
+        else if (value > 40) /* above logging.ERROR */
+            level = AC_LogError + 1;
+        else if (value > 30)
+            level = AC_LogError;
+        else if (value > 20)
+            level = AC_LogWarning;
+        else if (value > 10)
+            level = AC_LogInfo;
     }
+    buffer->records = NULL;
+    buffer->length = buffer->capacity = 0;
+    buffer->level = level;
+    currentLog = buffer;
+}
 
+/* Returns the level of the logging module matching a library report level,
+ * or 0 for an unknown one. */
+static int
+loggingLevel(int level)
+{
     switch (level) {
         case -1: /* LOGDEBUG */
-            PyObject_CallMethod(logger, "debug", "s", msg);
-            break;
+            return 10;
         case 0: /* INFO */
-            PyObject_CallMethod(logger, "info", "s", msg);
-            break;
+            return 20;
         case 1: /* WARNING */
-            PyObject_CallMethod(logger, "warning", "s", msg);
-            break;
+            return 30;
         case 2: /* LOGERROR */
-            PyObject_CallMethod(logger, "error", "s", msg);
-            break;
+            return 40;
         default:
-            break;
+            return 0;
     }
 }
 
-#if PY_MAJOR_VERSION >= 3
-#define MEMNEW(size) PyMem_RawCalloc(1, size)
-#define MEMFREE(ptr) PyMem_RawFree(ptr)
-#define MEMRENEW(ptr, size) PyMem_RawRealloc(ptr, size)
-#else
-#define MEMNEW(size) PyMem_Malloc(size)
-#define MEMFREE(ptr) PyMem_Free(ptr)
-#define MEMRENEW(ptr, size) PyMem_Realloc(ptr, size)
-#endif
+/* Stops collecting messages into buffer, and releases the ones collected. */
+static void
+clearLog(LogBuffer* buffer)
+{
+    size_t i;
+
+    currentLog = NULL;
+
+    for (i = 0; i < buffer->length; i++)
+        MEMFREE(buffer->records[i].msg);
+
+    MEMFREE(buffer->records);
+    buffer->records = NULL;
+    buffer->length = buffer->capacity = 0;
+}
+
+/* Passes the collected messages to the "_psautohint" logger, in the order
+ * they were reported, and releases them. Must be called with the GIL held. */
+static void
+endLog(LogBuffer* buffer)
+{
+    PyObject* logger;
+    PyObject *type, *value, *traceback;
+    size_t i;
+
+    currentLog = NULL;
+
+    /* Don't let the logging clobber the exception of a failed call. */
+    PyErr_Fetch(&type, &value, &traceback);
+
+    logger = buffer->length > 0 ? getLogger() : NULL;
+
+    for (i = 0; logger != NULL && i < buffer->length; i++) {
+        int level = loggingLevel(buffer->records[i].level);
+        PyObject* result;
+
+        if (level == 0)
+            continue;
+
+        result = PyObject_CallMethod(logger, "log", "is", level,
+                                     buffer->records[i].msg);
+        if (result == NULL)
+            PyErr_Clear();
+        Py_XDECREF(result);
+    }
+
+    clearLog(buffer);
+
+    PyErr_Restore(type, value, traceback);
+}
+
+/* Returns the messages collected in buffer from start to end as a new list
+ * of (level, message) tuples, with the levels of the logging module, or NULL
+ * on error. Must be called with the GIL held. */
+static PyObject*
+getLogRecords(LogBuffer* buffer, size_t start, size_t end)
+{
+    PyObject* list = PyList_New(0);
+    size_t i;
+
+    for (i = start; list != NULL && i < end; i++) {
+        int level = loggingLevel(buffer->records[i].level);
+        PyObject* record;
+
+        if (level == 0)
+            continue;
+
+        record = Py_BuildValue("(is)", level, buffer->records[i].msg);
+        if (record == NULL || PyList_Append(list, record) < 0)
+            Py_CLEAR(list);
+        Py_XDECREF(record);
+    }
+
+    return list;
+}
+
 
 static void*
 memoryManager(void* ctx, void* ptr, size_t size)
@@ -92,6 +270,171 @@ memoryManager(void* ctx, void* ptr, size_t size)
 
 static PyObject* PsAutoHintError;
 
+/* Sets the exception for a failed library call, if result is not
+ * AC_Success. */
+static void
+setHintingError(int result)
+{
+    switch (result) {
+        case AC_Success:
+            break;
+        case AC_FatalError:
+            PyErr_SetString(PsAutoHintError, "Fatal error");
+            break;
+        case AC_MemoryError:
+            PyErr_NoMemory();
+            break;
+        case AC_InvalidParameterError:
+            PyErr_SetString(PyExc_ValueError, "Invalid glyph data");
+            break;
+        case AC_UnknownError:
+        default:
+            PyErr_SetString(PsAutoHintError, "Hinting failed");
+            break;
+    }
+}
+
+/* A bytes-like object passed to the library as a null terminated string.
+ * Bytes objects already are null terminated and are used in place, the data
+ * of other objects is copied. */
+typedef struct
+{
+    Py_buffer view;
+    char* copy;
+    const char* str;
+} InputString;
+
+static bool
+getInputString(PyObject* obj, InputString* input)
+{
+    input->copy = NULL;
+    input->str = NULL;
+
+    if (PyObject_GetBuffer(obj, &input->view, PyBUF_SIMPLE) < 0)
+        return false;
+
+    if (PyBytes_Check(obj)) {
+        input->str = input->view.buf;
+        return true;
+    }
+
+    input->copy = MEMNEW(input->view.len + 1);
+    if (!input->copy) {
+        PyBuffer_Release(&input->view);
+        PyErr_NoMemory();
+        return false;
+    }
+    memcpy(input->copy, input->view.buf, input->view.len);
+    input->str = input->copy;
+
+    return true;
+}
+
+static void
+releaseInputString(InputString* input)
+{
+    if (!input->str)
+        return;
+
+    MEMFREE(input->copy);
+    PyBuffer_Release(&input->view);
+    input->copy = NULL;
+    input->str = NULL;
+}
+
+/* The hinted bez data is passed by AutoHintStringWrite() to outputCB(),
+ * which writes it straight into the bytes object that is returned. The object
+ * can't be resized without the GIL, so it is allocated beforehand with a
+ * guess of the size, and what does not fit goes to an overflow buffer that is
+ * appended to it by finishOutput(). */
+typedef struct
+{
+    PyObject* bytes;
+    size_t length;
+    size_t capacity;
+    char* overflow;
+    size_t overflowLength;
+    size_t overflowCapacity;
+    bool failed;
+} OutputSink;
+
+static bool
+beginOutput(OutputSink* sink, size_t size)
+{
+    sink->bytes = PyBytes_FromStringAndSize(NULL, size);
+    sink->length = 0;
+    sink->capacity = size;
+    sink->overflow = NULL;
+    sink->overflowLength = sink->overflowCapacity = 0;
+    sink->failed = false;
+
+    return sink->bytes != NULL;
+}
+
+static void
+outputCB(void* userData, const char* data, size_t length)
+{
+    OutputSink* sink = userData;
+    size_t room = sink->capacity - sink->length;
+    size_t n = length < room ? length : room;
+
+    memcpy(PyBytes_AS_STRING(sink->bytes) + sink->length, data, n);
+    sink->length += n;
+    data += n;
+    length -= n;
+
+    if (length == 0 || sink->failed)
+        return;
+
+    if (sink->overflowLength + length > sink->overflowCapacity) {
+        size_t capacity = 2 * sink->overflowCapacity;
+        char* overflow;
+        if (capacity < sink->overflowLength + length)
+            capacity = sink->overflowLength + length;
+        overflow = MEMRENEW(sink->overflow, capacity);
+        if (!overflow) {
+            sink->failed = true;
+            return;
+        }
+        sink->overflow = overflow;
+        sink->overflowCapacity = capacity;
+    }
+
+    memcpy(sink->overflow + sink->overflowLength, data, length);
+    sink->overflowLength += length;
+}
+
+/* Returns the bytes object of the sink, sized to the data written, or NULL
+ * with an exception set if result is not AC_Success. Must be called with the
+ * GIL held. */
+static PyObject*
+finishOutput(OutputSink* sink, int result)
+{
+    PyObject* bytes = sink->bytes;
+
+    if (result == AC_Success && sink->failed)
+        result = AC_MemoryError;
+
+    if (result == AC_Success &&
+        _PyBytes_Resize(&bytes, sink->length + sink->overflowLength) == 0) {
+        memcpy(PyBytes_AS_STRING(bytes) + sink->length, sink->overflow,
+               sink->overflowLength);
+    } else if (result == AC_Success) {
+        /* _PyBytes_Resize() released the object and set the exception. */
+        bytes = NULL;
+    } else {
+        Py_CLEAR(bytes);
+    }
+
+    MEMFREE(sink->overflow);
+    sink->overflow = NULL;
+    sink->bytes = NULL;
+
+    setHintingError(result);
+
+    return bytes;
+}
+
 static char autohint_doc[] =
   "Autohint glyphs.\n"
   "\n"
@@ -105,6 +448,8 @@ static char autohint_doc[] =
   "  allow_hint_sub: no multiple layers of coloring.\n"
   "  round: round coordinates.\n"
   "\n"
+  "  font_info and glyph may be bytes or any other bytes-like object.\n"
+  "\n"
   "Output:\n"
   "  Autohinted glyph data in bez format.\n"
   "\n"
@@ -117,63 +462,51 @@ autohint(PyObject* self, PyObject* args)
     int allowEdit = true, roundCoords = true, allowHintSub = true;
     PyObject* fontObj = NULL;
     PyObject* inObj = NULL;
-    PyObject* outObj = NULL;
-    char* inData = NULL;
-    char* fontInfo = NULL;
-    bool error = true;
+    InputString fontInfo, inData;
+    ACFontInfo* fontinfo = NULL;
+    ACContext* context = NULL;
+    OutputSink sink;
+    int result = AC_MemoryError;
+    LogBuffer logBuffer;
 
-    if (!PyArg_ParseTuple(args, "O!O!|iii", &PyBytes_Type, &fontObj,
-                          &PyBytes_Type, &inObj, &allowEdit, &allowHintSub,
-                          &roundCoords))
+    if (!PyArg_ParseTuple(args, "OO|iii", &fontObj, &inObj, &allowEdit,
+                          &allowHintSub, &roundCoords))
         return NULL;
 
-    AC_SetMemManager(NULL, memoryManager);
-    AC_SetReportCB(reportCB);
-
-    fontInfo = PyBytes_AsString(fontObj);
-    inData = PyBytes_AsString(inObj);
-    if (inData && fontInfo) {
-        int result = -1;
-
-        size_t outLen = 4 * strlen(inData);
-        char* output = MEMNEW(outLen);
-        if (output) {
-            result = AutoHintString(inData, fontInfo, &output, &outLen,
-                                    allowEdit, allowHintSub, roundCoords);
+    if (!getInputString(fontObj, &fontInfo))
+        return NULL;
+    if (!getInputString(inObj, &inData)) {
+        releaseInputString(&fontInfo);
+        return NULL;
+    }
 
-            if (result == AC_Success) {
-                error = false;
-                outObj = PyBytes_FromString(output);
-            }
+    /* The hinted glyph is usually less than twice the size of the input. */
+    if (!beginOutput(&sink, 2 * (size_t)inData.view.len + 64)) {
+        releaseInputString(&fontInfo);
+        releaseInputString(&inData);
+        return NULL;
+    }
 
-            MEMFREE(output);
-        }
+    beginLog(&logBuffer);
+    Py_BEGIN_ALLOW_THREADS
+    fontinfo = AC_CompileFontInfo(fontInfo.str);
+    context = AC_NewContext();
+    AC_SetContextReportLevel(context, logBuffer.level);
+    if (fontinfo && context)
+        result = AutoHintStringWrite(context, fontinfo, inData.str, outputCB,
+                                     &sink, allowEdit, allowHintSub,
+                                     roundCoords);
+    else if (context)
+        result = AC_FatalError;
+    AC_FreeContext(context);
+    AC_FreeFontInfo(fontinfo);
+    Py_END_ALLOW_THREADS
+    endLog(&logBuffer);
 
-        if (result != AC_Success) {
-            switch (result) {
-                case -1:
-                    /* Do nothing, we already called PyErr_* */
-                    break;
-                case AC_FatalError:
-                    PyErr_SetString(PsAutoHintError, "Fatal error");
-                    break;
-                case AC_MemoryError:
-                    PyErr_NoMemory();
-                    break;
-                case AC_InvalidParameterError:
-                    PyErr_SetString(PyExc_ValueError, "Invalid glyph data");
-                    break;
-                case AC_UnknownError:
-                default:
-                    PyErr_SetString(PsAutoHintError, "Hinting failed");
-                    break;
-            }
-        }
-    }
+    releaseInputString(&fontInfo);
+    releaseInputString(&inData);
 
-    if (error)
-        return NULL;
-    return outObj;
+    return finishOutput(&sink, result);
 }
 
 static char autohintmm_doc[] =
@@ -202,13 +535,19 @@ autohintmm(PyObject* self, PyObject* args)
     Py_ssize_t mastersCount = 0;
     PyObject* fontObj = NULL;
     PyObject* outSeq = NULL;
-    char* fontInfo = NULL;
-    const char** masters;
-    bool error = true;
+    InputString fontInfo;
+    InputString* inputs = NULL;
+    const char** masters = NULL;
+    const char** inGlyphs = NULL;
+    char** outGlyphs = NULL;
+    size_t* outputSizes = NULL;
+    int result = -1;
+    ACContext* context = NULL;
+    LogBuffer logBuffer;
     Py_ssize_t i;
 
-    if (!PyArg_ParseTuple(args, "O!O!O!", &PyBytes_Type, &fontObj,
-                          &PyTuple_Type, &inObj, &PyTuple_Type, &mastersObj))
+    if (!PyArg_ParseTuple(args, "OO!O!", &fontObj, &PyTuple_Type, &inObj,
+                          &PyTuple_Type, &mastersObj))
         return NULL;
 
     inCount = PyTuple_GET_SIZE(inObj);
@@ -225,104 +564,651 @@ autohintmm(PyObject* self, PyObject* args)
         return NULL;
     }
 
+    if (!getInputString(fontObj, &fontInfo))
+        return NULL;
+
+    /* The masters followed by the glyphs. */
+    inputs = MEMNEW(2 * inCount * sizeof(InputString));
     masters = MEMNEW(mastersCount * sizeof(char*));
-    if (!masters) {
+    inGlyphs = MEMNEW(inCount * sizeof(char*));
+    outGlyphs = MEMNEW(inCount * sizeof(char*));
+    outputSizes = MEMNEW(inCount * sizeof(size_t));
+    if (!inputs || !masters || !inGlyphs || !outGlyphs || !outputSizes) {
         PyErr_NoMemory();
-        return NULL;
+        goto done;
     }
 
     for (i = 0; i < mastersCount; i++) {
         PyObject* obj = PyTuple_GET_ITEM(mastersObj, i);
-        masters[i] = PyBytes_AsString(obj);
-        if (!masters[i])
+        if (!getInputString(obj, &inputs[i]))
             goto done;
+        masters[i] = inputs[i].str;
     }
 
-    fontInfo = PyBytes_AsString(fontObj);
-    if (!fontInfo)
-        goto done;
-
-    AC_SetMemManager(NULL, memoryManager);
-    AC_SetReportCB(reportCB);
+    for (i = 0; i < inCount; i++) {
+        PyObject* glyphObj = PyTuple_GET_ITEM(inObj, i);
+        InputString* glyph = &inputs[mastersCount + i];
+        if (!getInputString(glyphObj, glyph))
+            goto done;
+        inGlyphs[i] = glyph->str;
+        outputSizes[i] = 4 * (size_t)glyph->view.len + 64;
+        outGlyphs[i] = MEMNEW(outputSizes[i]);
+        if (!outGlyphs[i]) {
+            PyErr_NoMemory();
+            goto done;
+        }
+    }
 
     outSeq = PyTuple_New(inCount);
-    if (outSeq) {
-        int result = -1;
+    if (!outSeq)
+        goto done;
 
-        const char** inGlyphs = MEMNEW(inCount * sizeof(char*));
-        char** outGlyphs = MEMNEW(inCount * sizeof(char*));
-        size_t* outputSizes = MEMNEW(inCount * sizeof(size_t*));
-        if (!inGlyphs || !outGlyphs || !outputSizes) {
-            PyErr_NoMemory();
-            goto finish;
-        }
+    beginLog(&logBuffer);
+    Py_BEGIN_ALLOW_THREADS
+    context = AC_NewContext();
+    AC_SetContextReportLevel(context, logBuffer.level);
+    if (context)
+        result = AutoHintStringMMCtx(context, inGlyphs, fontInfo.str,
+                                     mastersCount, masters, outGlyphs,
+                                     outputSizes);
+    else
+        result = AC_MemoryError;
+    AC_FreeContext(context);
+    Py_END_ALLOW_THREADS
+    endLog(&logBuffer);
 
+    if (result == AC_Success) {
+        /* outputSizes are the exact lengths of the data. */
         for (i = 0; i < inCount; i++) {
-            PyObject* glyphObj = PyTuple_GET_ITEM(inObj, i);
-            inGlyphs[i] = PyBytes_AsString(glyphObj);
-            if (!inGlyphs[i])
-                goto finish;
-            outputSizes[i] = 4 * strlen(inGlyphs[i]);
-            outGlyphs[i] = MEMNEW(outputSizes[i]);
+            PyObject* outObj =
+              PyBytes_FromStringAndSize(outGlyphs[i], outputSizes[i]);
+            if (!outObj) {
+                result = -1;
+                break;
+            }
+            PyTuple_SET_ITEM(outSeq, i, outObj);
         }
+    } else {
+        setHintingError(result);
+    }
 
-        result = AutoHintStringMM(inGlyphs, fontInfo, mastersCount, masters,
-                                  outGlyphs, outputSizes);
-        if (result == AC_Success) {
-            error = false;
-            for (i = 0; i < inCount; i++) {
-                PyObject* outObj = PyBytes_FromString(outGlyphs[i]);
-                PyTuple_SET_ITEM(outSeq, i, outObj);
+done:
+    if (inputs) {
+        for (i = 0; i < 2 * inCount; i++)
+            releaseInputString(&inputs[i]);
+    }
+    if (outGlyphs) {
+        for (i = 0; i < inCount; i++)
+            MEMFREE(outGlyphs[i]);
+    }
+    releaseInputString(&fontInfo);
+    MEMFREE(inputs);
+    MEMFREE(masters);
+    MEMFREE(inGlyphs);
+    MEMFREE(outGlyphs);
+    MEMFREE(outputSizes);
+
+    if (result != AC_Success) {
+        Py_XDECREF(outSeq);
+        return NULL;
+    }
+
+    return outSeq;
+}
+
+static char autohint_charstring_doc[] =
+  "Autohint a glyph into a Type 2 charstring.\n"
+  "\n"
+  "Signature:\n"
+  "  autohint_charstring(font_info, glyph, width[, allow_edit,\n"
+  "                      allow_hint_sub, round])\n"
+  "\n"
+  "Args:\n"
+  "  font_info: font information.\n"
+  "  glyph: glyph data in bez format.\n"
+  "  width: width operand of the charstring, or None.\n"
+  "  allow_edit: allow editing (changing) the paths when hinting.\n"
+  "  allow_hint_sub: no multiple layers of coloring.\n"
+  "  round: round coordinates.\n"
+  "\n"
+  "Output:\n"
+  "  Autohinted glyph as a Type 2 charstring.\n"
+  "\n"
+  "Raises:\n"
+  "  psautohint.error: If autohinting fails.\n";
+
+static PyObject*
+autohint_charstring(PyObject* self, PyObject* args)
+{
+    int allowEdit = true, roundCoords = true, allowHintSub = true;
+    PyObject* fontObj = NULL;
+    PyObject* inObj = NULL;
+    PyObject* widthObj = NULL;
+    PyObject* outObj = NULL;
+    InputString fontInfo, inData;
+    ACFontInfo* fontinfo = NULL;
+    ACContext* context = NULL;
+    unsigned char* output = NULL;
+    size_t outLen;
+    double width = 0;
+    int result = AC_MemoryError;
+    LogBuffer logBuffer;
+
+    if (!PyArg_ParseTuple(args, "OOO|iii", &fontObj, &inObj, &widthObj,
+                          &allowEdit, &allowHintSub, &roundCoords))
+        return NULL;
+
+    if (widthObj != Py_None) {
+        width = PyFloat_AsDouble(widthObj);
+        if (width == -1 && PyErr_Occurred())
+            return NULL;
+    }
+
+    if (!getInputString(fontObj, &fontInfo))
+        return NULL;
+    if (!getInputString(inObj, &inData)) {
+        releaseInputString(&fontInfo);
+        return NULL;
+    }
+
+    outLen = inData.view.len + 1;
+    output = MEMNEW(outLen);
+    if (!output) {
+        releaseInputString(&fontInfo);
+        releaseInputString(&inData);
+        return PyErr_NoMemory();
+    }
+
+    beginLog(&logBuffer);
+    Py_BEGIN_ALLOW_THREADS
+    fontinfo = AC_CompileFontInfo(fontInfo.str);
+    context = AC_NewContext();
+    AC_SetContextReportLevel(context, logBuffer.level);
+    if (fontinfo && context)
+        result = AutoHintCharstring(context, fontinfo, inData.str,
+                                    widthObj != Py_None ? &width : NULL,
+                                    &output, &outLen, allowEdit,
+                                    allowHintSub, roundCoords);
+    else if (context)
+        result = AC_FatalError;
+    AC_FreeContext(context);
+    AC_FreeFontInfo(fontinfo);
+    Py_END_ALLOW_THREADS
+    endLog(&logBuffer);
+
+    releaseInputString(&fontInfo);
+    releaseInputString(&inData);
+
+    if (result == AC_Success)
+        outObj = PyBytes_FromStringAndSize((const char*)output, outLen);
+    MEMFREE(output);
+
+    setHintingError(result);
+
+    return outObj;
+}
+
+static char autohint_batch_doc[] =
+  "Autohint glyphs that share the same font information.\n"
+  "\n"
+  "Signature:\n"
+  "  autohint_batch(font_info, glyphs[, widths, allow_edit,\n"
+  "                 allow_hint_sub, round])\n"
+  "\n"
+  "Args:\n"
+  "  font_info: font information.\n"
+  "  glyphs: sequence of glyph data in bez format.\n"
+  "  widths: None to return the glyphs in bez format, otherwise a sequence\n"
+  "    of the width operands of their charstrings, or None, to return them\n"
+  "    as Type 2 charstrings as autohint_charstring() does.\n"
+  "  allow_edit: allow editing (changing) the paths when hinting.\n"
+  "  allow_hint_sub: no multiple layers of coloring.\n"
+  "  round: round coordinates.\n"
+  "\n"
+  "  font_info and the glyphs may be bytes or any other bytes-like object.\n"
+  "\n"
+  "Output:\n"
+  "  List of (glyph, records) tuples, one per input glyph. glyph is the\n"
+  "  autohinted glyph, or the exception autohint() would have raised for\n"
+  "  it. records is the list of the (level, message) tuples the library\n"
+  "  reported while hinting it, with the levels of the logging module;\n"
+  "  they are returned rather than logged, so that the caller can log\n"
+  "  them with the glyph they belong to.\n";
+
+/* A glyph of autohint_batch(), with either its bez or charstring output. */
+typedef struct
+{
+    InputString input;
+    OutputSink sink;
+    unsigned char* charstring;
+    size_t length;
+    double width;
+    bool hasWidth;
+    int result;
+    size_t firstRecord; /* of the glyph's messages in the LogBuffer */
+} BatchGlyph;
+
+static PyObject*
+autohint_batch(PyObject* self, PyObject* args)
+{
+    int allowEdit = true, roundCoords = true, allowHintSub = true;
+    PyObject* fontObj = NULL;
+    PyObject* glyphsObj = NULL;
+    PyObject* widthsObj = Py_None;
+    PyObject* glyphSeq = NULL;
+    PyObject* widthSeq = NULL;
+    PyObject* outList = NULL;
+    InputString fontInfo;
+    BatchGlyph* glyphs = NULL;
+    ACFontInfo* fontinfo = NULL;
+    ACContext* context = NULL;
+    bool charstrings;
+    LogBuffer logBuffer = { NULL, 0, 0, AC_LogDebug };
+    Py_ssize_t i, count;
+
+    if (!PyArg_ParseTuple(args, "OO|Oiii", &fontObj, &glyphsObj, &widthsObj,
+                          &allowEdit, &allowHintSub, &roundCoords))
+        return NULL;
+
+    charstrings = widthsObj != Py_None;
+
+    glyphSeq = PySequence_Fast(glyphsObj, "glyphs must be a sequence");
+    if (!glyphSeq)
+        return NULL;
+    count = PySequence_Fast_GET_SIZE(glyphSeq);
+
+    if (charstrings) {
+        widthSeq = PySequence_Fast(widthsObj, "widths must be a sequence");
+        if (!widthSeq)
+            goto done;
+        if (PySequence_Fast_GET_SIZE(widthSeq) != count) {
+            PyErr_SetString(
+              PyExc_TypeError,
+              "Length of \"widths\" must equal length of \"glyphs\".");
+            goto done;
+        }
+    }
+
+    if (!getInputString(fontObj, &fontInfo))
+        goto done;
+
+    glyphs = MEMNEW((count ? count : 1) * sizeof(BatchGlyph));
+    if (!glyphs) {
+        PyErr_NoMemory();
+        goto release;
+    }
+
+    for (i = 0; i < count; i++) {
+        BatchGlyph* glyph = &glyphs[i];
+        PyObject* glyphObj = PySequence_Fast_GET_ITEM(glyphSeq, i);
+
+        if (!getInputString(glyphObj, &glyph->input))
+            goto release;
+
+        if (charstrings) {
+            PyObject* widthObj = PySequence_Fast_GET_ITEM(widthSeq, i);
+            if (widthObj != Py_None) {
+                glyph->width = PyFloat_AsDouble(widthObj);
+                if (glyph->width == -1 && PyErr_Occurred())
+                    goto release;
+                glyph->hasWidth = true;
             }
+            glyph->length = glyph->input.view.len + 1;
+            glyph->charstring = MEMNEW(glyph->length);
+            if (!glyph->charstring) {
+                PyErr_NoMemory();
+                goto release;
+            }
+        } else if (!beginOutput(&glyph->sink,
+                                2 * (size_t)glyph->input.view.len + 64)) {
+            goto release;
         }
+    }
 
-    finish:
-        if (outGlyphs) {
-            for (i = 0; i < inCount; i++)
-                MEMFREE(outGlyphs[i]);
+    /* The fontinfo is compiled and the context created once for all the
+     * glyphs. Their messages are collected together, and returned with the
+     * glyph each was reported for. */
+    beginLog(&logBuffer);
+    Py_BEGIN_ALLOW_THREADS
+    fontinfo = AC_CompileFontInfo(fontInfo.str);
+    context = AC_NewContext();
+    AC_SetContextReportLevel(context, logBuffer.level);
+    for (i = 0; i < count; i++) {
+        BatchGlyph* glyph = &glyphs[i];
+        glyph->firstRecord = logBuffer.length;
+        if (!context)
+            glyph->result = AC_MemoryError;
+        else if (!fontinfo)
+            glyph->result = AC_FatalError;
+        else if (charstrings)
+            glyph->result = AutoHintCharstring(
+              context, fontinfo, glyph->input.str,
+              glyph->hasWidth ? &glyph->width : NULL, &glyph->charstring,
+              &glyph->length, allowEdit, allowHintSub, roundCoords);
+        else
+            glyph->result = AutoHintStringWrite(
+              context, fontinfo, glyph->input.str, outputCB, &glyph->sink,
+              allowEdit, allowHintSub, roundCoords);
+    }
+    AC_FreeContext(context);
+    AC_FreeFontInfo(fontinfo);
+    Py_END_ALLOW_THREADS
+
+    outList = PyList_New(count);
+    if (!outList)
+        goto release;
+
+    for (i = 0; i < count; i++) {
+        BatchGlyph* glyph = &glyphs[i];
+        size_t lastRecord =
+          i + 1 < count ? glyphs[i + 1].firstRecord : logBuffer.length;
+        PyObject *outObj, *records, *item;
+
+        if (!charstrings) {
+            outObj = finishOutput(&glyph->sink, glyph->result);
+        } else if (glyph->result == AC_Success) {
+            outObj = PyBytes_FromStringAndSize((const char*)glyph->charstring,
+                                               glyph->length);
+        } else {
+            setHintingError(glyph->result);
+            outObj = NULL;
         }
 
-        MEMFREE(inGlyphs);
-        MEMFREE(outGlyphs);
-        MEMFREE(outputSizes);
-
-        if (result != AC_Success) {
-            switch (result) {
-                case -1:
-                    /* Do nothing, we already called PyErr_* */
-                    break;
-                case AC_FatalError:
-                    PyErr_SetString(PsAutoHintError, "Fatal error");
-                    break;
-                case AC_MemoryError:
-                    PyErr_NoMemory();
-                    break;
-                case AC_InvalidParameterError:
-                    PyErr_SetString(PyExc_ValueError, "Invalid glyph data");
-                    break;
-                case AC_UnknownError:
-                default:
-                    PyErr_SetString(PsAutoHintError, "Hinting failed");
-                    break;
+        /* The error of the glyph takes its place in the list. */
+        if (!outObj) {
+            PyObject *type, *traceback;
+            PyErr_Fetch(&type, &outObj, &traceback);
+            PyErr_NormalizeException(&type, &outObj, &traceback);
+            Py_XDECREF(type);
+            Py_XDECREF(traceback);
+            if (!outObj) {
+                Py_CLEAR(outList);
+                goto release;
             }
         }
+
+        records = getLogRecords(&logBuffer, glyph->firstRecord, lastRecord);
+        item = records ? PyTuple_New(2) : NULL;
+        if (!item) {
+            Py_DECREF(outObj);
+            Py_XDECREF(records);
+            Py_CLEAR(outList);
+            goto release;
+        }
+        PyTuple_SET_ITEM(item, 0, outObj);
+        PyTuple_SET_ITEM(item, 1, records);
+        PyList_SET_ITEM(outList, i, item);
     }
 
+release:
+    clearLog(&logBuffer);
+    if (glyphs) {
+        for (i = 0; i < count; i++) {
+            releaseInputString(&glyphs[i].input);
+            Py_XDECREF(glyphs[i].sink.bytes);
+            MEMFREE(glyphs[i].sink.overflow);
+            MEMFREE(glyphs[i].charstring);
+        }
+    }
+    MEMFREE(glyphs);
+    releaseInputString(&fontInfo);
+
 done:
-    MEMFREE(masters);
+    Py_XDECREF(glyphSeq);
+    Py_XDECREF(widthSeq);
 
-    if (error) {
-        Py_XDECREF(outSeq);
+    return outList;
+}
+
+/* The local or global subroutines of a font, kept in a capsule so that the
+ * ACSubrs arrays are built once per font rather than once per glyph. */
+typedef struct
+{
+    ACSubrs subrs;
+    PyObject* tuple; /* owns the subroutine data */
+} SubrsCapsule;
+
+#define SUBRS_CAPSULE "psautohint.subrs"
+
+static void
+freeSubrsCapsule(PyObject* capsule)
+{
+    SubrsCapsule* sc = PyCapsule_GetPointer(capsule, SUBRS_CAPSULE);
+
+    if (sc == NULL)
+        return;
+
+    Py_XDECREF(sc->tuple);
+    MEMFREE((void*)sc->subrs.data);
+    MEMFREE((void*)sc->subrs.lengths);
+    MEMFREE(sc);
+}
+
+static char compile_subrs_doc[] =
+  "Prepare subroutines for decode_charstring().\n"
+  "\n"
+  "Signature:\n"
+  "  compile_subrs(subrs)\n"
+  "\n"
+  "Args:\n"
+  "  subrs: sequence of subroutine charstrings, as bytes.\n"
+  "\n"
+  "Output:\n"
+  "  Opaque object to pass to decode_charstring().\n";
+
+static PyObject*
+compile_subrs(PyObject* self, PyObject* args)
+{
+    PyObject* subrsObj = NULL;
+    PyObject* tuple;
+    PyObject* capsule;
+    SubrsCapsule* sc;
+    const unsigned char** data;
+    size_t* lengths;
+    Py_ssize_t i, count;
+
+    if (!PyArg_ParseTuple(args, "O", &subrsObj))
         return NULL;
+
+    tuple = PySequence_Tuple(subrsObj);
+    if (!tuple)
+        return NULL;
+
+    count = PyTuple_GET_SIZE(tuple);
+    sc = MEMNEW(sizeof(SubrsCapsule));
+    data = MEMNEW((count ? count : 1) * sizeof(unsigned char*));
+    lengths = MEMNEW((count ? count : 1) * sizeof(size_t));
+    if (!sc || !data || !lengths) {
+        MEMFREE(sc);
+        MEMFREE(data);
+        MEMFREE(lengths);
+        Py_DECREF(tuple);
+        return PyErr_NoMemory();
     }
 
-    return outSeq;
+    sc->subrs.count = (int)count;
+    sc->subrs.data = data;
+    sc->subrs.lengths = lengths;
+    sc->tuple = tuple;
+
+    capsule = PyCapsule_New(sc, SUBRS_CAPSULE, freeSubrsCapsule);
+    if (!capsule) {
+        sc->tuple = NULL;
+        Py_DECREF(tuple);
+        MEMFREE(data);
+        MEMFREE(lengths);
+        MEMFREE(sc);
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        PyObject* obj = PyTuple_GET_ITEM(tuple, i);
+        char* buf;
+        Py_ssize_t len;
+        if (PyBytes_AsStringAndSize(obj, &buf, &len) < 0) {
+            Py_DECREF(capsule);
+            return NULL;
+        }
+        data[i] = (const unsigned char*)buf;
+        lengths[i] = len;
+    }
+
+    return capsule;
+}
+
+static const ACSubrs*
+getSubrs(PyObject* obj, bool* error)
+{
+    SubrsCapsule* sc;
+
+    if (obj == Py_None)
+        return NULL;
+
+    sc = PyCapsule_GetPointer(obj, SUBRS_CAPSULE);
+    if (!sc) {
+        *error = true;
+        return NULL;
+    }
+
+    return &sc->subrs;
+}
+
+/* Formats a decoded path as bez, as otfFont.convertT2GlyphToBez() does. */
+static PyObject*
+pathToBez(const ACPath* path, bool allowDecimals)
+{
+    static const char* opNames[] = { "mt", "dt", "ct", "cp" };
+    static const int opArgs[] = { 2, 2, 6, 0 };
+    PyObject* bezObj;
+    const int* c = path->coords;
+    char* bez;
+    size_t len = 0, size;
+    int i, j;
+
+    /* At most 6 numbers of 16 characters and an operator per line. */
+    size = (size_t)path->nops * (6 * 16 + 4) + 8;
+    bez = MEMNEW(size);
+    if (!bez)
+        return PyErr_NoMemory();
+
+    if (path->nops > 0)
+        len += sprintf(bez + len, "sc\n");
+    for (i = 0; i < path->nops; i++) {
+        int op = path->ops[i];
+        for (j = 0; j < opArgs[op]; j++, c++) {
+            if (allowDecimals)
+                len += sprintf(bez + len, "%.2f ", *c / (double)AC_FIXEDONE);
+            else
+                len += sprintf(bez + len, "%d ", *c / AC_FIXEDONE);
+        }
+        len += sprintf(bez + len, "%s\n", opNames[op]);
+    }
+    len += sprintf(bez + len, "ed\n");
+
+    bezObj = PyBytes_FromStringAndSize(bez, len);
+    MEMFREE(bez);
+
+    return bezObj;
+}
+
+static char decode_charstring_doc[] =
+  "Convert a Type 2 charstring to bez.\n"
+  "\n"
+  "Signature:\n"
+  "  decode_charstring(charstring, local_subrs, global_subrs[,\n"
+  "                    allow_decimals])\n"
+  "\n"
+  "Args:\n"
+  "  charstring: Type 2 charstring, as a bytes-like object.\n"
+  "  local_subrs: local subroutines from compile_subrs(), or None.\n"
+  "  global_subrs: global subroutines from compile_subrs(), or None.\n"
+  "  allow_decimals: keep two decimals of the coordinates.\n"
+  "\n"
+  "Output:\n"
+  "  Tuple of the glyph data in bez format, without hints, and of the width\n"
+  "  operand of the charstring, or None if it has none.\n"
+  "\n"
+  "Raises:\n"
+  "  psautohint.error: If the charstring can't be decoded, as for seac\n"
+  "  composites.\n";
+
+static PyObject*
+decode_charstring(PyObject* self, PyObject* args)
+{
+    PyObject* csObj = NULL;
+    PyObject* localObj = NULL;
+    PyObject* globalObj = NULL;
+    PyObject* bezObj;
+    PyObject* widthObj;
+    const ACSubrs* localSubrs;
+    const ACSubrs* globalSubrs;
+    Py_buffer charstring;
+    int allowDecimals = false;
+    bool error = false;
+    ACPath* path = NULL;
+    double width = 0;
+    int hasWidth = false;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "OOO|i", &csObj, &localObj, &globalObj,
+                          &allowDecimals))
+        return NULL;
+
+    localSubrs = getSubrs(localObj, &error);
+    globalSubrs = getSubrs(globalObj, &error);
+    if (error)
+        return NULL;
+
+    /* The charstring has a length, so it is read in place whatever object
+     * holds it. */
+    if (PyObject_GetBuffer(csObj, &charstring, PyBUF_SIMPLE) < 0)
+        return NULL;
+
+    result = AC_DecodeCharstring(
+      NULL, (const unsigned char*)charstring.buf, charstring.len, localSubrs,
+      globalSubrs, allowDecimals, &path, &width, &hasWidth);
+    PyBuffer_Release(&charstring);
+    if (result != AC_Success) {
+        if (result == AC_MemoryError)
+            PyErr_NoMemory();
+        else
+            PyErr_SetString(PsAutoHintError, "Invalid charstring");
+        return NULL;
+    }
+
+    bezObj = pathToBez(path, allowDecimals);
+    AC_FreePath(path);
+    if (!bezObj)
+        return NULL;
+
+    if (!hasWidth) {
+        Py_INCREF(Py_None);
+        widthObj = Py_None;
+    } else if (width == (long)width) {
+        /* Keep integer widths integers, so that they are written back
+         * with the shorter encoding. */
+        widthObj = PyLong_FromLong((long)width);
+    } else {
+        widthObj = PyFloat_FromDouble(width);
+    }
+    if (!widthObj) {
+        Py_DECREF(bezObj);
+        return NULL;
+    }
+
+    return Py_BuildValue("(NN)", bezObj, widthObj);
 }
 
 /* clang-format off */
 static PyMethodDef psautohint_methods[] = {
   { "autohint", autohint, METH_VARARGS, autohint_doc },
   { "autohintmm", autohintmm, METH_VARARGS, autohintmm_doc },
+  { "autohint_charstring", autohint_charstring, METH_VARARGS,
+    autohint_charstring_doc },
+  { "autohint_batch", autohint_batch, METH_VARARGS, autohint_batch_doc },
+  { "compile_subrs", compile_subrs, METH_VARARGS, compile_subrs_doc },
+  { "decode_charstring", decode_charstring, METH_VARARGS,
+    decode_charstring_doc },
   { NULL, NULL, 0, NULL }
 };
 /* clang-format on */
@@ -333,6 +1219,8 @@ static char psautohint_doc[] =
   "autohint() -- Autohint glyphs.\n";
 
 #define SETUPMODULE                                                            \
+    AC_SetMemManager(NULL, memoryManager);                                     \
+    AC_SetReportCB(reportCB);                                                  \
     PyModule_AddStringConstant(m, "version", AC_getVersion());                 \
     PsAutoHintError = PyErr_NewException("psautohint.error", NULL, NULL);      \
     Py_INCREF(PsAutoHintError);                                                \
@@ -30,17 +30,32 @@
 
 from __future__ import print_function, absolute_import
 
+import functools
+import hashlib
+import itertools
+import json
 import logging
+import multiprocessing
 import os
 import re
+import tempfile
+import threading
 import time
 
+try:
+    from concurrent.futures import ThreadPoolExecutor
+except ImportError:  # Python 2 without the futures backport
+    ThreadPoolExecutor = None
+
+from fontTools.misc.py23 import tobytes, tounicode
+
 from .otfFont import CFFFontData
 from .ufoFont import UFOFontData
+from . import _psautohint
 from ._psautohint import error as PsAutoHintCError
 
-from . import (get_font_format, hint_bez_glyph, hint_compatible_bez_glyphs,
-               FontParseError)
+from . import (get_font_format, hint_bez_glyph, hint_glyph_charstring,
+               hint_glyphs, hint_compatible_bez_glyphs, FontParseError)
 
 
 log = logging.getLogger(__name__)
@@ -69,6 +84,9 @@ class ACOptions(object):
         self.writeToDefaultLayer = False
         self.baseMaster = {}
         self.font_format = None
+        self.threads = 1  # number of threads hinting the glyphs of a font
+        self.jobs = 1  # number of processes hinting the glyphs of a font
+        self.hintCache = None  # directory of the HintCache, if any
 
 
 class ACHintError(Exception):
@@ -218,9 +236,311 @@ def hintFiles(options):
         hintFile(options, path, outpath, reference_master=False)
 
 
-def hintFile(options, path, outpath, reference_master):
+# Type 2 charstring operators that start with hints.
+T2_HINT_OPS = (1, 3, 18, 19, 20, 23)
+
+
+def charStringHasHints(charString):
+    # Skip the operands, the first operator tells whether there are hints.
+    data = bytearray(charString)
+    i = 0
+    while i < len(data):
+        b0 = data[i]
+        if 32 <= b0 <= 246:
+            i += 1
+        elif 247 <= b0 <= 254:
+            i += 2
+        elif b0 == 28:
+            i += 3
+        elif b0 == 255:
+            i += 5
+        else:
+            return b0 in T2_HINT_OPS
+    return False
+
+
+def _beginHinting(options, name, dictName):
+    nameAliases = options.nameAliases
+
+    if dictName is not None:
+        log.info("%s: Begin hinting (using fdDict %s).",
+                 nameAliases.get(name, name), dictName)
+    else:
+        log.info("%s: Begin hinting.", nameAliases.get(name, name))
+
+
+def _endHinting(hinted, width):
+    if width is not None:
+        if not charStringHasHints(hinted):
+            log.info("No hints added!")
+        return
+
+    if not (("ry" in hinted[:200]) or ("rb" in hinted[:200]) or
+       ("rm" in hinted[:200]) or ("rv" in hinted[:200])):
+        log.info("No hints added!")
+
+
+def _hintError(options, name):
     nameAliases = options.nameAliases
+    return ACHintError("%s: Failure in processing outline data." %
+                       nameAliases.get(name, name))
+
+
+def hintGlyph(options, name, bezString, fontInfo, dictName, fontFileName,
+              baseBezString, width=None):
+    # The glyph is hinted straight to a Type 2 charstring when a width is
+    # given, and to bez otherwise.
+    _beginHinting(options, name, dictName)
+
+    # Call auto-hint library on bez string.
+    try:
+        if width is not None:
+            hinted = hint_glyph_charstring(fontInfo, bezString, width,
+                                           options.allowChanges,
+                                           not options.noHintSub,
+                                           options.allowDecimalCoords)
+        elif baseBezString is None:
+            hinted = hint_bez_glyph(fontInfo, bezString,
+                                    options.allowChanges,
+                                    not options.noHintSub,
+                                    options.allowDecimalCoords)
+        else:
+            baseFontFileName = os.path.basename(options.reference_font)
+            masters = [baseFontFileName, fontFileName]
+            glyphs = [baseBezString, bezString]
+            hinted = hint_compatible_bez_glyphs(fontInfo, glyphs, masters)
+            hinted = hinted[1]  # FIXME
+    except PsAutoHintCError:
+        raise _hintError(options, name)
+
+    _endHinting(hinted, width)
+
+    return hinted
+
+
+class HintCache(object):
+    """Hinted glyphs kept on disk across runs, one file per glyph.
+
+    The files are named after a hash of everything the hinting of a glyph
+    depends on: the library version, the hinting options, the fontinfo, the
+    glyph and, when hinting against a reference font, the reference font and
+    glyph. A change to any of them gives another name, so entries never need
+    to be invalidated; the directory can be deleted at any time.
+
+    An entry holds the messages the library logged while hinting the glyph,
+    as a line of JSON, followed by the hinted glyph. Only the messages that
+    passed the level of the "_psautohint" logger are stored, so the level is
+    part of the name too.
+    """
+
+    def __init__(self, path):
+        self.path = path
+
+    def key(self, options, task):
+        (name, bezString, fontInfo, dictName, fontFileName, baseBezString,
+         width) = task
+        level = logging.getLogger("_psautohint").getEffectiveLevel()
+        parts = [_psautohint.version, repr(options.allowChanges),
+                 repr(options.noHintSub), repr(options.allowDecimalCoords),
+                 repr(width), repr(level), fontInfo, bezString]
+        if baseBezString is not None:
+            parts += [os.path.abspath(options.reference_font), fontFileName,
+                      baseBezString]
+        digest = hashlib.sha256()
+        for part in parts:
+            part = tobytes(part, encoding="utf-8")
+            digest.update(tobytes(str(len(part))) + b":" + part)
+        return digest.hexdigest()
+
+    def _entryPath(self, key):
+        return os.path.join(self.path, key[:2], key[2:])
+
+    def get(self, key, width):
+        # Returns the (hinted, records) pair stored by put(), or None.
+        try:
+            with open(self._entryPath(key), "rb") as f:
+                data = f.read()
+        except (IOError, OSError):
+            return None
+        header, _, data = data.partition(b"\n")
+        try:
+            records = [(level, msg) for level, msg in
+                       json.loads(tounicode(header, "utf-8"))]
+        except (TypeError, ValueError):
+            return None
+        if width is None:
+            data = tounicode(data, "utf-8")
+        return data, records
+
+    def put(self, key, hinted, records):
+        # The entry is written to a temporary file first, so that other
+        # processes sharing the cache never read a partial one.
+        path = self._entryPath(key)
+        try:
+            directory = os.path.dirname(path)
+            if not os.path.isdir(directory):
+                os.makedirs(directory)
+            fd, tmpPath = tempfile.mkstemp(dir=directory)
+            with os.fdopen(fd, "wb") as f:
+                f.write(tobytes(json.dumps(records)) + b"\n")
+                f.write(tobytes(hinted, encoding="utf-8"))
+            try:
+                os.rename(tmpPath, path)
+            except OSError:
+                # Another process stored the same entry first (Windows).
+                os.remove(tmpPath)
+        except (IOError, OSError) as ex:
+            log.warning("Could not write to hint cache %s: %s", self.path, ex)
+
+
+def _batchKey(task):
+    # fontInfo, whether hinted against the reference font, output format.
+    return (task[2], task[5] is not None, task[6] is None)
+
+
+def _logRecords(records):
+    # Logs the (level, message) pairs hint_glyphs() returned for a glyph.
+    logger = logging.getLogger("_psautohint")
+    for level, msg in records:
+        logger.log(level, msg)
+
+
+class _RecordCollector(logging.Handler):
+    # Collects the messages the library logs from the current thread, as the
+    # (level, message) pairs hint_glyphs() returns.
+    def __init__(self):
+        logging.Handler.__init__(self)
+        self.thread = threading.current_thread().ident
+        self.records = []
+
+    def emit(self, record):
+        if record.thread == self.thread:
+            self.records.append((record.levelno, record.getMessage()))
+
+
+def _hintRun(options, tasks, key):
+    # Hints glyphs with the same _batchKey() with one call to the library,
+    # returns a (hinted, records) pair per glyph.
+    widths = None if key[2] else [task[6] for task in tasks]
+    return hint_glyphs(key[0], [task[1] for task in tasks], widths,
+                       options.allowChanges, not options.noHintSub,
+                       options.allowDecimalCoords)
+
+
+def _iterHintGlyphs(options, tasks):
+    # Yields the hinted glyphs in order, each once its messages are logged.
+    # Runs of glyphs that share the same fontinfo and output format are
+    # hinted with one call to the library before their messages are logged.
+    # A glyph that fails is yielded as its ACHintError, so that the glyphs
+    # before it are still stored. Glyphs found in the hint cache, if any, are
+    # not hinted again; the library messages stored with them are logged
+    # instead.
+    cache = None
+    if options.hintCache and not options.logOnly:
+        cache = HintCache(options.hintCache)
+
+    for key, run in itertools.groupby(tasks, _batchKey):
+        run = list(run)
+        keys = cached = [None] * len(run)
+        if cache is not None:
+            keys = [cache.key(options, task) for task in run]
+            cached = [cache.get(k, task[6]) for k, task in zip(keys, run)]
+
+        batch = None
+        if not key[1]:
+            missing = [task for task, entry in zip(run, cached)
+                       if entry is None]
+            if missing:
+                batch = iter(_hintRun(options, missing, key))
+
+        for task, cacheKey, entry in zip(run, keys, cached):
+            if entry is not None:
+                hinted, records = entry
+                _beginHinting(options, task[0], task[3])
+                log.debug("Using cached hints.")
+                _logRecords(records)
+                _endHinting(hinted, task[6])
+                yield hinted
+                continue
+
+            if batch is None:
+                # The library messages are logged as the glyph is hinted,
+                # and collected for the cache.
+                collector = _RecordCollector()
+                libLog = logging.getLogger("_psautohint")
+                libLog.addHandler(collector)
+                try:
+                    hinted = hintGlyph(options, *task)
+                except ACHintError as ex:
+                    hinted = ex
+                finally:
+                    libLog.removeHandler(collector)
+                if isinstance(hinted, ACHintError):
+                    yield hinted
+                    continue
+                records = collector.records
+            else:
+                hinted, records = next(batch)
+                _beginHinting(options, task[0], task[3])
+                _logRecords(records)
+                if isinstance(hinted, PsAutoHintCError):
+                    yield _hintError(options, task[0])
+                    continue
+                elif isinstance(hinted, Exception):
+                    raise hinted
+                _endHinting(hinted, task[6])
+
+            if cache is not None:
+                cache.put(cacheKey, hinted, records)
+            yield hinted
+
+
+def _hintGlyphs(options, tasks):
+    # The messages are logged as the glyphs are hinted, none are returned.
+    return [(hinted, []) for hinted in _iterHintGlyphs(options, tasks)]
+
 
+# Number of glyphs hinted at once, see hintFile().
+JOB_CHUNK_SIZE = 16
+
+# State of a worker process, set up by _initJob().
+_jobOptions = None
+_jobLogRecords = []
+
+
+class _JobLogHandler(logging.Handler):
+    def emit(self, record):
+        # Only the formatted message is sent back to the main process.
+        record.msg = record.getMessage()
+        record.args = None
+        record.exc_info = None
+        _jobLogRecords.append(record)
+
+
+def _initJob(options, level):
+    global _jobOptions
+    _jobOptions = options
+
+    # Collect the log records, to be passed to the main process with the
+    # glyphs they belong to.
+    root = logging.getLogger()
+    for handler in root.handlers[:]:
+        root.removeHandler(handler)
+    root.addHandler(_JobLogHandler())
+    root.setLevel(level)
+
+
+def _hintJob(tasks):
+    # The log records of each glyph are passed on with it.
+    del _jobLogRecords[:]
+    results = []
+    for hinted in _iterHintGlyphs(_jobOptions, tasks):
+        results.append((hinted, list(_jobLogRecords)))
+        del _jobLogRecords[:]
+    return results
+
+
+def hintFile(options, path, outpath, reference_master):
     fontFileName = os.path.basename(path)
     log.info("Hinting font %s. Start time: %s.", path, time.asctime())
 
@@ -233,7 +553,9 @@ def hintFile(options, path, outpath, reference_master):
         raise FontParseError("Selected glyph list is empty for font <%s>." %
                              fontFileName)
 
-    fontInfo = ""
+    # The fontinfo is encoded once per font dictionary, the extension then
+    # reads it in place for every glyph.
+    fontInfo = b""
 
     # Check counter glyphs, if any.
     counter_glyphs = options.hCounterGlyphs + options.vCounterGlyphs
@@ -286,7 +608,7 @@ def hintFile(options, path, outpath, reference_master):
 
     if fdGlyphDict is None:
         fdDict = fontDictList[0]
-        fontInfo = fdDict.getFontInfo()
+        fontInfo = tobytes(fdDict.getFontInfo())
     else:
         log.info("Using alternate FDDict global values from fontinfo "
                  "file for some glyphs.")
@@ -298,78 +620,133 @@ def hintFile(options, path, outpath, reference_master):
     if isCID:
         options.noFlex = True
 
-    seenGlyphCount = 0
-    processedGlyphCount = 0
-    for name in glyphList:
-        seenGlyphCount += 1
-
-        # Convert to bez format
-        bezString, width = fontData.convertToBez(name, options.read_hints,
-                                                 options.hintAll)
-        if bezString is None or "mt" not in bezString:
-            # skip empty glyphs.
-            continue
-
-        processedGlyphCount += 1
-
-        # get new fontinfo string if FDarray index has changed,
-        # as each FontDict has different alignment zones.
-        gid = fontData.getGlyphID(name)
-        if isCID:
-            fdIndex = fontData.getfdIndex(gid)
-            if not fdIndex == lastFDIndex:
-                lastFDIndex = fdIndex
-                fdDict = fontData.getFontInfo(options.allow_no_blues,
-                                              options.noFlex,
-                                              options.vCounterGlyphs,
-                                              options.hCounterGlyphs,
-                                              fdIndex)
-                fontInfo = fdDict.getFontInfo()
-        else:
-            if fdGlyphDict is not None:
-                fdIndex = fdGlyphDict[name][0]
-                if lastFDIndex != fdIndex:
-                    lastFDIndex = fdIndex
-                    fdDict = fontDictList[fdIndex]
-                    fontInfo = fdDict.getFontInfo()
+    # The glyphs are read and stored back in order, only the hinting itself
+    # is done in chunks of JOB_CHUNK_SIZE glyphs, each hinted with as few
+    # calls to the extension as their fontinfo allows. The chunks are spread
+    # over worker processes, or over worker threads, which the extension
+    # allows by releasing the GIL while hinting. The log records of the
+    # processes are passed on here in glyph order. A bounded number of chunks
+    # is in flight at a time.
+    pool = executor = None
+    workers = 1
+    if options.jobs > 1:
+        jobOptions = ACOptions()
+        jobOptions.__dict__.update(options.__dict__)
+        jobOptions.baseMaster = {}
+        level = min(log.getEffectiveLevel(),
+                    logging.getLogger("_psautohint").getEffectiveLevel())
+        pool = multiprocessing.Pool(options.jobs, _initJob,
+                                    (jobOptions, level))
+        workers = options.jobs
+    elif options.threads > 1 and ThreadPoolExecutor is not None:
+        executor = ThreadPoolExecutor(options.threads)
+        workers = options.threads
+    pending = []
+    jobGlyphs, jobTasks = [], []
+
+    # CFF glyphs are hinted straight to charstrings, unless the bez is needed
+    # as the reference for the other fonts.
+    toCharString = (not options.logOnly and not options.reference_font and
+                    hasattr(fontData, "updateFromCharstring"))
+
+    def finishGlyphs(glyphs, results):
+        changed = False
+        for (name, width), (hinted, records) in zip(glyphs, results):
+            for record in records:
+                logger = logging.getLogger(record.name)
+                if logger.isEnabledFor(record.levelno):
+                    logger.handle(record)
+            if isinstance(hinted, ACHintError):
+                raise hinted
+
+            if toCharString:
+                changed = True
+                fontData.updateFromCharstring(hinted, name)
+                continue
 
-        # Build autohint point list identifier
+            if reference_master or not options.reference_font:
+                options.baseMaster[name] = hinted
 
-        if fdGlyphDict:
-            log.info("%s: Begin hinting (using fdDict %s).",
-                     nameAliases.get(name, name), fdDict.DictName)
-        else:
-            log.info("%s: Begin hinting.", nameAliases.get(name, name))
+            if options.logOnly:
+                continue
 
-        # Call auto-hint library on bez string.
-        try:
-            if reference_master or not options.reference_font:
-                newBezString = hint_bez_glyph(fontInfo, bezString,
-                                              options.allowChanges,
-                                              not options.noHintSub,
-                                              options.allowDecimalCoords)
-                options.baseMaster[name] = newBezString
-            else:
-                baseFontFileName = os.path.basename(options.reference_font)
-                masters = [baseFontFileName, fontFileName]
-                glyphs = [options.baseMaster[name], bezString]
-                newBezString = hint_compatible_bez_glyphs(fontInfo, glyphs,
-                                                          masters)
-                newBezString = newBezString[1]  # FIXME
-        except PsAutoHintCError:
-            raise ACHintError("%s: Failure in processing outline data." %
-                              nameAliases.get(name, name))
-
-        if not (("ry" in newBezString[:200]) or ("rb" in newBezString[:200]) or
-           ("rm" in newBezString[:200]) or ("rv" in newBezString[:200])):
-            log.info("No hints added!")
+            # Convert bez to charstring, and update CFF.
+            changed = True
+            fontData.updateFromBez(hinted, name, width)
+        return changed
 
-        if options.logOnly:
-            continue
+    def submitJob(tasks):
+        # Returns the function giving the results of the chunk.
+        if pool is not None:
+            return pool.apply_async(_hintJob, (tasks,)).get
+        if executor is not None:
+            return executor.submit(_hintGlyphs, options, tasks).result
+        return functools.partial(_hintGlyphs, options, tasks)
 
-        # Convert bez to charstring, and update CFF.
-        anyGlyphChanged = True
-        fontData.updateFromBez(newBezString, name, width)
+    seenGlyphCount = 0
+    processedGlyphCount = 0
+    try:
+        for name in glyphList:
+            seenGlyphCount += 1
+
+            # Convert to bez format
+            bezString, width = fontData.convertToBez(name, options.read_hints,
+                                                     options.hintAll)
+            if bezString is None or "mt" not in bezString:
+                # skip empty glyphs.
+                continue
+
+            processedGlyphCount += 1
+
+            # get new fontinfo string if FDarray index has changed,
+            # as each FontDict has different alignment zones.
+            gid = fontData.getGlyphID(name)
+            if isCID:
+                fdIndex = fontData.getfdIndex(gid)
+                if not fdIndex == lastFDIndex:
+                    lastFDIndex = fdIndex
+                    fdDict = fontData.getFontInfo(options.allow_no_blues,
+                                                  options.noFlex,
+                                                  options.vCounterGlyphs,
+                                                  options.hCounterGlyphs,
+                                                  fdIndex)
+                    fontInfo = tobytes(fdDict.getFontInfo())
+            else:
+                if fdGlyphDict is not None:
+                    fdIndex = fdGlyphDict[name][0]
+                    if lastFDIndex != fdIndex:
+                        lastFDIndex = fdIndex
+                        fdDict = fontDictList[fdIndex]
+                        fontInfo = tobytes(fdDict.getFontInfo())
+
+            dictName = fdDict.DictName if fdGlyphDict else None
+            if reference_master or not options.reference_font:
+                baseBezString = None
+            else:
+                baseBezString = options.baseMaster[name]
+            task = (name, bezString, fontInfo, dictName, fontFileName,
+                    baseBezString, width if toCharString else None)
+
+            jobGlyphs.append((name, width))
+            jobTasks.append(task)
+            if len(jobTasks) == JOB_CHUNK_SIZE:
+                pending.append((jobGlyphs, submitJob(jobTasks)))
+                jobGlyphs, jobTasks = [], []
+
+            while len(pending) > 2 * workers:
+                glyphs, getResults = pending.pop(0)
+                anyGlyphChanged |= finishGlyphs(glyphs, getResults())
+
+        if jobTasks:
+            pending.append((jobGlyphs, submitJob(jobTasks)))
+        for glyphs, getResults in pending:
+            anyGlyphChanged |= finishGlyphs(glyphs, getResults())
+    finally:
+        if pool is not None:
+            pool.terminate()
+            pool.join()
+        if executor is not None:
+            executor.shutdown()
 
     if not options.logOnly:
         if anyGlyphChanged:
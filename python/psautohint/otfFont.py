@@ -11,10 +11,10 @@ import os
 import re
 
 from fontTools.misc.psCharStrings import T2OutlineExtractor, SimpleT2Decompiler
-from fontTools.misc.py23 import bytechr, byteord, open
+from fontTools.misc.py23 import bytechr, byteord, open, tounicode
 from fontTools.ttLib import TTFont, getTableClass
 
-from . import fdTools, FontParseError
+from . import fdTools, FontParseError, _psautohint
 
 
 log = logging.getLogger(__name__)
@@ -257,6 +257,12 @@ def convertT2GlyphToBez(t2CharString, read_hints=True, allowDecimals=False):
     return "".join(extractor.bezProgram), width
 
 
+def getBytecode(charString):
+    if charString.bytecode is None:
+        charString.compile()
+    return charString.bytecode
+
+
 class HintMask:
     # class used to collect hints for the current
     # hint mask when converting bez to T2.
@@ -700,6 +706,7 @@ class CFFFontData:
         self.charStrings = self.topDict.CharStrings
         self.charStringIndex = self.charStrings.charStringsIndex
         self.allowDecimalCoords = allow_decimal_coords
+        self.subrsCache = {}
 
     def getGlyphList(self):
         return self.ttFont.getGlyphOrder()
@@ -711,10 +718,18 @@ class CFFFontData:
         t2Wdth = None
         gid = self.charStrings.charStrings[glyphName]
         t2CharString = self.charStringIndex[gid]
+        bezString = None
+        if not read_hints:
+            # The library decodes the charstring natively, T2ToBezExtractor
+            # is only needed for the hints and the charstrings it rejects.
+            try:
+                bezString, t2Wdth = self.decodeCharString(t2CharString)
+            except _psautohint.error:
+                pass
         try:
-            bezString, t2Wdth = convertT2GlyphToBez(t2CharString,
-                                                    read_hints,
-                                                    self.allowDecimalCoords)
+            if bezString is None:
+                bezString, t2Wdth = convertT2GlyphToBez(
+                    t2CharString, read_hints, self.allowDecimalCoords)
             # Note: the glyph name is important, as it is used by autohintexe
             # for various heuristics, including [hv]stem3 derivation.
             bezString = "% " + glyphName + "\n" + bezString
@@ -724,11 +739,39 @@ class CFFFontData:
             bezString = None
         return bezString, t2Wdth
 
+    def getSubrs(self, subrs):
+        # The subroutines are passed to the library once per INDEX.
+        if not subrs:
+            return None
+        key = id(subrs)
+        if key not in self.subrsCache:
+            data = [getBytecode(subr) for subr in subrs]
+            self.subrsCache[key] = (subrs, _psautohint.compile_subrs(data))
+        return self.subrsCache[key][1]
+
+    def decodeCharString(self, t2CharString):
+        private = t2CharString.private
+        localSubrs = self.getSubrs(getattr(private, "Subrs", []))
+        globalSubrs = self.getSubrs(t2CharString.globalSubrs)
+        bezString, width = _psautohint.decode_charstring(
+            getBytecode(t2CharString), localSubrs, globalSubrs,
+            self.allowDecimalCoords)
+        if width is None:
+            # Same as convertT2GlyphToBez() for the default width.
+            width = private.defaultWidthX - private.nominalWidthX
+        return tounicode(bezString), width
+
     def updateFromBez(self, bezData, glyphName, width):
         t2Program = [width] + convertBezToT2(bezData)
         gid = self.charStrings.charStrings[glyphName]
         t2CharString = self.charStringIndex[gid]
-        t2CharString.program = t2Program
+        # The charstring may still hold the bytecode it was decoded from.
+        t2CharString.setProgram(t2Program)
+
+    def updateFromCharstring(self, charString, glyphName):
+        gid = self.charStrings.charStrings[glyphName]
+        t2CharString = self.charStringIndex[gid]
+        t2CharString.setBytecode(charString)
 
     def save(self, out_path):
         if out_path is None:
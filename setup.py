@@ -15,6 +15,11 @@ class CustomBuildExt(build_ext):
             # module) is compiled with -O3 and tree vectorize:
             # https://github.com/khaledhosny/psautohint/issues/16
             ext.extra_compile_args.append("-fno-tree-vectorize")
+            # AutoHintStringParallel() uses POSIX threads.
+            ext.extra_compile_args.append("-pthread")
+            if ext.extra_link_args is None:
+                ext.extra_link_args = []
+            ext.extra_link_args.append("-pthread")
 
         build_ext.build_extension(self, ext)
 
@@ -29,8 +34,10 @@ module1 = Extension("psautohint._psautohint",
                         "libpsautohint/src/acfixed.c",
                         "libpsautohint/src/auto.c",
                         "libpsautohint/src/bbox.c",
+                        "libpsautohint/src/buffer.c",
                         "libpsautohint/src/charpath.c",
                         "libpsautohint/src/charpathpriv.c",
+                        "libpsautohint/src/charstring.c",
                         "libpsautohint/src/charprop.c",
                         "libpsautohint/src/check.c",
                         "libpsautohint/src/control.c",
@@ -51,6 +58,7 @@ module1 = Extension("psautohint._psautohint",
                         "libpsautohint/src/report.c",
                         "libpsautohint/src/shuffle.c",
                         "libpsautohint/src/stemreport.c",
+                        "libpsautohint/src/thread.c",
                         "libpsautohint/src/write.c",
                     ],
                     depends=[
@@ -58,12 +66,14 @@ module1 = Extension("psautohint._psautohint",
                         "libpsautohint/src/ac.h",
                         "libpsautohint/src/basic.h",
                         "libpsautohint/src/bbox.h",
+                        "libpsautohint/src/buffer.h",
                         "libpsautohint/src/charpath.h",
                         "libpsautohint/src/fontinfo.h",
                         "libpsautohint/src/logging.h",
                         "libpsautohint/src/memory.h",
                         "libpsautohint/src/opcodes.h",
                         "libpsautohint/src/optable.h",
+                        "libpsautohint/src/thread.h",
                         "libpsautohint/src/winstdint.h",
                         "libpsautohint/src/version.h",
                     ],
@@ -1,13 +1,18 @@
 from __future__ import print_function, division, absolute_import
 
 import glob
+import logging
 from os.path import basename
 import pytest
+import time
+
+from fontTools.ttLib import TTFont
 
 from psautohint import FontParseError
 from psautohint.__main__ import main as psautohint
 
 from . import make_temp_copy, DATA_DIR
+from .differ import main as differ
 
 
 # font.otf, font.cff, font.ufo
@@ -200,6 +205,68 @@ def test_argumentless_option(path, option, tmpdir):
     autohint([path, '-o', out, option])
 
 
+@pytest.mark.parametrize("path", FONTS)
+def test_jobs(path, tmpdir, caplog, monkeypatch):
+    # The font and the log are the same as when hinting serially, but for
+    # the times logged.
+    monkeypatch.setattr(time, "asctime", lambda: "")
+    caplog.set_level(logging.INFO)
+    out1 = str(tmpdir / basename(path)) + ".out1"
+    out2 = str(tmpdir / basename(path)) + ".out2"
+
+    def messages():
+        msgs = [(r.name, r.levelno, r.getMessage()) for r in caplog.records]
+        caplog.clear()
+        return msgs
+
+    autohint([path, '-o', out1, '-v'])
+    msgs = messages()
+    assert msgs
+
+    autohint([path, '-o', out2, '-v', '--jobs', '2'])
+    assert messages() == msgs
+
+    if path.endswith(".otf"):
+        # The head table has the time the font was saved.
+        assert (TTFont(out1).getTableData("CFF ") ==
+                TTFont(out2).getTableData("CFF "))
+    elif path.endswith(".cff"):
+        assert differ([out1, out2, '-m', 'bin'])
+    else:
+        assert differ([out1, out2])
+
+
+@pytest.mark.parametrize("path", FONTS)
+def test_cache(path, tmpdir, caplog):
+    cache = str(tmpdir / "cache")
+    out1 = str(tmpdir / basename(path)) + ".out1"
+    out2 = str(tmpdir / basename(path)) + ".out2"
+
+    def library_messages():
+        msgs = [r.getMessage() for r in caplog.records
+                if r.name == "_psautohint"]
+        caplog.clear()
+        return msgs
+
+    autohint([path, '-o', out1, '--cache', cache])
+    entries = sorted(glob.glob("%s/*/*" % cache))
+    assert entries
+    msgs = library_messages()
+
+    # The second run takes all the glyphs from the cache, and logs the
+    # library messages stored with them.
+    autohint([path, '-o', out2, '--cache', cache])
+    assert sorted(glob.glob("%s/*/*" % cache)) == entries
+    assert library_messages() == msgs
+
+
+@pytest.mark.parametrize("jobs", ["0", "-1", "foo"])
+def test_invalid_jobs(jobs):
+    path = "%s/dummy/font.otf" % DATA_DIR
+    with pytest.raises(SystemExit):
+        autohint([path, '--jobs', jobs])
+
+
 @pytest.mark.parametrize("option", [
     "--doc-fddict",
     "--help",
@@ -1,3 +1,4 @@
+import logging
 import pytest
 import sys
 
@@ -112,3 +113,267 @@ def test_autohintmm_bad_glyphs(glyphs):
 ])
 def test_autohint_too_many_counter_glyphs(info):
     _psautohint.autohint(info, GLYPH)
+
+
+def test_autohint_threads():
+    futures = pytest.importorskip("concurrent.futures")
+    expected = _psautohint.autohint(INFO, GLYPH)
+    with futures.ThreadPoolExecutor(4) as executor:
+        results = list(executor.map(lambda g: _psautohint.autohint(INFO, g),
+                                    16 * [GLYPH]))
+    assert results == 16 * [expected]
+
+
+def test_autohint_log(caplog):
+    with pytest.raises(_psautohint.error):
+        _psautohint.autohint(INFO, b"% foo\nry")
+    msgs = [r.getMessage() for r in caplog.records if r.name == "_psautohint"]
+    assert any("Stack underflow" in m for m in msgs)
+
+
+def test_autohint_log_level(caplog):
+    def debug_records():
+        return [r for r in caplog.records
+                if r.name == "_psautohint" and r.levelno == logging.DEBUG]
+
+    with caplog.at_level(logging.DEBUG, logger="_psautohint"):
+        _psautohint.autohint(INFO, GLYPH)
+    assert debug_records()
+
+    caplog.clear()
+    with caplog.at_level(logging.INFO, logger="_psautohint"):
+        _psautohint.autohint(INFO, GLYPH)
+    assert not debug_records()
+
+
+# 10 560 500 rmoveto -500 vlineto -500 hlineto 500 vlineto endchar
+CHARSTRING = (b"\x95\xf8\xc4\xf8\x88\x15\xfc\x88\x07\xfc\x88\x06"
+              b"\xf8\x88\x07\x0e")
+# -500 vlineto return
+SUBR = b"\xfc\x88\x07\x0b"
+# 10 560 500 rmoveto -107 callgsubr -500 hlineto 500 vlineto endchar
+SUBR_CHARSTRING = (b"\x95\xf8\xc4\xf8\x88\x15\x20\x1d\xfc\x88\x06"
+                   b"\xf8\x88\x07\x0e")
+
+
+def test_decode_charstring():
+    bez, width = _psautohint.decode_charstring(CHARSTRING, None, None)
+    assert bez == GLYPH.split(b"\n", 3)[3]
+    assert width == 10
+
+
+def test_decode_charstring_subrs():
+    subrs = _psautohint.compile_subrs([SUBR])
+    result = _psautohint.decode_charstring(SUBR_CHARSTRING, None, subrs)
+    assert result == _psautohint.decode_charstring(CHARSTRING, None, None)
+    with pytest.raises(_psautohint.error):
+        _psautohint.decode_charstring(SUBR_CHARSTRING, subrs, None)
+
+
+@pytest.mark.parametrize("charstring", [
+    b"\x8c\x8d\x8e\x8f\x0e",  # endchar with seac arguments
+    b"\x8c\x8d\x0c\x0a",      # add
+    b"\x8c\x15",              # rmoveto with one argument
+    b"\x1c\x01",              # truncated number
+])
+def test_decode_bad_charstring(charstring):
+    with pytest.raises(_psautohint.error):
+        _psautohint.decode_charstring(charstring, None, None)
+
+
+# 500 0 500 hstem 60 500 vstem 560 500 rmoveto 0 -500 rlineto ... endchar
+HINTED_CHARSTRING = (b"\xf8\x88\x8b\xf8\x88\x01\xc7\xf8\x88\x03"
+                     b"\xf8\xc4\xf8\x88\x15\x8b\xfc\x88\x05\xfc\x88\x8b\x05"
+                     b"\x8b\xf8\x88\x05\x0e")
+
+
+def test_autohint_charstring():
+    charstring = _psautohint.autohint_charstring(INFO, GLYPH, 500)
+    assert charstring == HINTED_CHARSTRING
+    charstring = _psautohint.autohint_charstring(INFO, GLYPH, None)
+    assert charstring == HINTED_CHARSTRING[2:]
+
+
+# Two boxes whose vertical stems overlap, hinted with a hint replacement.
+SUBST_GLYPH = b"""% foo
+sc
+0 0 mt
+60 0 dt
+60 300 dt
+0 300 dt
+cp
+30 400 mt
+90 400 dt
+90 700 dt
+30 700 dt
+cp
+ed
+"""
+# 0 700 hstemhm hintmask(11) ... hintmask(101) ... endchar
+SUBST_CHARSTRING = (b"\x8b\xf9\x50\x12\x8b\xc7\x6d\xc7\x13\xc0\x8b\x8b\x15\xc7"
+                    b"\x8b\x05\x8b\xf7\xc0\x05\x4f\x8b\x05\x13\xa0\xa9\xef\x15"
+                    b"\xc7\x8b\x05\x8b\xf7\xc0\x05\x4f\x8b\x05\x0e")
+
+# Three equal stems of a counter glyph, hinted with vstem3.
+COUNTER_GLYPH = b"% m\nsc\n" + b"".join(
+    b"%d 0 mt\n%d 0 dt\n%d 500 dt\n%d 500 dt\ncp\n" % (x, x + 60, x + 60, x)
+    for x in (0, 250, 500)) + b"ed\n"
+# 0 500 hstem 0 60 190 60 190 60 vstem cntrmask(0111) ... endchar
+COUNTER_CHARSTRING = (b"\x8b\xf8\x88\x01\x8b\xc7\xf7\x52\xc7\xf7\x52\xc7\x03"
+                      b"\x14\x70\x8b\x8b\x15\xc7\x8b\x05\x8b\xf8\x88\x05\x4f"
+                      b"\x8b\x05\xf7\x8e\xfc\x88\x15\xc7\x8b\x05\x8b\xf8\x88"
+                      b"\x05\x4f\x8b\x05\xf7\x8e\xfc\x88\x15\xc7\x8b\x05\x8b"
+                      b"\xf8\x88\x05\x4f\x8b\x05\x0e")
+
+# A shallow dent in the bottom of a box, hinted with flex.
+FLEX_INFO = b"FontName Foo\nFlexOK true"
+FLEX_GLYPH = b"""% flex
+sc
+0 300 mt
+0 100 dt
+100 100 200 110 250 110 ct
+300 110 400 100 500 100 ct
+500 300 dt
+cp
+ed
+"""
+# 100 200 hstem 0 500 vstem 0 300 rmoveto 0 -200 rlineto ... 50 flex ...
+FLEX_CHARSTRING = (b"\xef\xf7\x5c\x01\x8b\xf8\x88\x03\x8b\xf7\xc0\x15\x8b\xfb"
+                   b"\x5c\x05\xef\x8b\xef\x95\xbd\x8b\xbd\x8b\xef\x81\xef\x8b"
+                   b"\xbd\x0c\x23\x8b\xf7\x5c\x05\x0e")
+
+# A box with fractional coordinates, hinted without rounding them.
+FIXED_GLYPH = b"""% frac
+sc
+0.5 0 mt
+60.25 0 dt
+60.25 500.75 dt
+0.5 500.75 dt
+cp
+ed
+"""
+# 0 501 hstem 0.5 59.75 vstem 0.5 0 rmoveto 59.75 0 rlineto ... endchar
+FIXED_CHARSTRING = (b"\x8b\xf8\x89\x01\xff\x00\x00\x80\x00\xff\x00\x3b\xc0\x00"
+                    b"\x03\xff\x00\x00\x80\x00\x8b\x15\xff\x00\x3b\xc0\x00\x8b"
+                    b"\x05\xff\x00\x00\x00\x00\xff\x01\xf4\xc0\x00\x05\xff\xff"
+                    b"\xc4\x40\x00\xff\x00\x00\x00\x00\x05\x0e")
+
+
+@pytest.mark.parametrize("info, glyph, rounding, expected", [
+    (INFO, SUBST_GLYPH, True, SUBST_CHARSTRING),
+    (INFO, COUNTER_GLYPH, True, COUNTER_CHARSTRING),
+    (FLEX_INFO, FLEX_GLYPH, True, FLEX_CHARSTRING),
+    (INFO, FIXED_GLYPH, False, FIXED_CHARSTRING),
+])
+def test_autohint_charstring_operators(info, glyph, rounding, expected):
+    charstring = _psautohint.autohint_charstring(info, glyph, None, True,
+                                                 True, rounding)
+    assert charstring == expected
+
+
+# 0 500 hstemhm, the 22 first of the 24 vertical stems, and the first
+# hintmask: the stems beyond the Type 2 limit are left out.
+MANY_STEMS_HINTS = (b"\x8b\xf8\x88\x12\x8b\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9"
+                    b"\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9"
+                    b"\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9\x9f\xa9"
+                    b"\x9f\xa9\x9f\xa9\x9f\xa9\x13\xd5\x55\x54")
+
+
+def test_autohint_charstring_hint_limit():
+    glyph = b"% many\nsc\n"
+    for x in range(0, 1200, 50):
+        glyph += b"%d 0 mt\n%d 0 dt\n%d 500 dt\n%d 500 dt\ncp\n" % (
+            x, x + 30, x + 30, x)
+    glyph += b"ed\n"
+    charstring = _psautohint.autohint_charstring(INFO, glyph, None)
+    assert charstring.startswith(MANY_STEMS_HINTS)
+
+
+@pytest.mark.parametrize("args", [
+    [INFO, GLYPH],                        # no width
+    [INFO, tounicode(GLYPH), 500],        # 2nd is string not bytes
+    [INFO, GLYPH, "500"],                 # width is a string
+])
+def test_autohint_charstring_bad_args(args):
+    with pytest.raises(TypeError):
+        _psautohint.autohint_charstring(*args)
+
+
+@pytest.mark.parametrize("buffer_type", [bytearray, memoryview])
+def test_autohint_buffers(buffer_type):
+    expected = _psautohint.autohint(INFO, GLYPH)
+    result = _psautohint.autohint(buffer_type(INFO), buffer_type(GLYPH))
+    assert result == expected
+    assert type(result) is bytes
+
+    expected = _psautohint.autohintmm(INFO, (GLYPH, GLYPH), (NAME, NAME))
+    result = _psautohint.autohintmm(buffer_type(INFO),
+                                    (buffer_type(GLYPH), GLYPH),
+                                    (buffer_type(NAME), NAME))
+    assert result == expected
+
+    expected = _psautohint.autohint_charstring(INFO, GLYPH, 500)
+    result = _psautohint.autohint_charstring(buffer_type(INFO),
+                                             buffer_type(GLYPH), 500)
+    assert result == expected
+
+
+def test_autohint_large_output():
+    # Staggered triangles, whose hint replacements make the output several
+    # times larger than the glyph.
+    glyph = b"% foo\nsc\n"
+    for i in range(12):
+        x, y = 37 * i, 53 * i
+        glyph += b"%d %d mt\n%d %d dt\n%d %d dt\ncp\n" % (
+            x, y, x + 60, y, x + 60, y + 80)
+    glyph += b"ed\n"
+    result = _psautohint.autohint(INFO, glyph)
+    assert len(result) > 4 * len(glyph)
+    assert result.endswith(b"cp\ned\n")
+    assert result == _psautohint.autohint(memoryview(INFO),
+                                          bytearray(glyph))
+
+
+def test_decode_charstring_buffer():
+    data = bytearray(b"\x00" + CHARSTRING)
+    result = _psautohint.decode_charstring(memoryview(data)[1:], None, None)
+    assert result == _psautohint.decode_charstring(CHARSTRING, None, None)
+
+
+def test_autohint_batch():
+    bad = b"% foo\nry"
+    results = _psautohint.autohint_batch(INFO, [GLYPH, bad, GLYPH])
+    hinted = [glyph for glyph, records in results]
+    assert hinted[0] == hinted[2] == _psautohint.autohint(INFO, GLYPH)
+    assert isinstance(hinted[1], _psautohint.error)
+
+    results = _psautohint.autohint_batch(INFO, (GLYPH, GLYPH), (500, None))
+    hinted = [glyph for glyph, records in results]
+    assert hinted == [HINTED_CHARSTRING, HINTED_CHARSTRING[2:]]
+
+    assert _psautohint.autohint_batch(INFO, []) == []
+
+
+def test_autohint_batch_log(caplog):
+    bad = b"% foo\nry"
+    with caplog.at_level(logging.DEBUG, logger="_psautohint"):
+        results = _psautohint.autohint_batch(INFO, [GLYPH, bad, GLYPH])
+    assert not [r for r in caplog.records if r.name == "_psautohint"]
+
+    records = [records for glyph, records in results]
+    assert records[0] and records[0] == records[2]
+    assert not any("Stack underflow" in msg for level, msg in records[0])
+    assert any(level == logging.ERROR and "Stack underflow" in msg
+               for level, msg in records[1])
+
+
+@pytest.mark.parametrize("args", [
+    [INFO],                             # 1 argument
+    [INFO, GLYPH],                      # 2nd is not a sequence of glyphs
+    [INFO, [tounicode(GLYPH)]],         # glyph is string not bytes
+    [INFO, [GLYPH], [500, 500]],        # more widths than glyphs
+    [INFO, [GLYPH], ["500"]],           # width is a string
+])
+def test_autohint_batch_bad_args(args):
+    with pytest.raises(TypeError):
+        _psautohint.autohint_batch(*args)